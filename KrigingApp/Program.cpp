@@ -11,13 +11,16 @@
  * Two arguments are required:
  * 1. KrigingParametersFile: Path to the JSON file containing kriging parameters.
  * 2. CompositesFile: Path to the CSV file containing composites data.
+ * 
+ * One argument is optional:
+ * 3. NumThreads: Number of worker threads; overrides 'NumThreads' in the parameters file. 0 uses all hardware threads.
  */
 void main(int argc, char* argv[])
 {
-	// Confirm two arguments were provided in additional to the exe
-	if (argc != 3)
+	// Confirm two or three arguments were provided in additional to the exe
+	if (argc != 3 && argc != 4)
 	{
-		LogAndThrow<std::invalid_argument>("Expected two parameters, but got " + std::to_string(argc - 1));
+		LogAndThrow<std::invalid_argument>("Expected two or three parameters, but got " + std::to_string(argc - 1));
 	}
 
 	// Parse args
@@ -28,11 +31,31 @@ void main(int argc, char* argv[])
 	KrigingParameters parameters;
 	parameters.SerializeParameters(parametersFilePath);
 
-	// Create blocks based on input parameters
-	Blocks blocks(parameters.BlockParameters);
+	// Optional thread count override
+	if (argc == 4)
+	{
+		int numThreads = std::stoi(argv[3]);
+		if (numThreads < 0)
+		{
+			LogAndThrow<std::invalid_argument>("Number of threads cannot be negative.");
+		}
+		parameters.NumThreads = numThreads;
+	}
+
+	// Read in composites filtered to interpolation area and validate; the kd-tree is built in the search ellipsoid's space
+	Composites composites(compositesFilePath, parameters.BlockParameters.BlockCoordExtents, parameters.GetMaxSearchRange(), parameters.Variables,
+		parameters.NumThreads, parameters.CacheComposites, parameters.KdTreeLeafSize, parameters.GetSearchAnisotropy());
+
+	// Cross-validate the composites instead of kriging blocks, writing to CSV in EXE directory
+	if (parameters.CrossValidation)
+	{
+		CrossValidationResults results = KrigingEngine::CrossValidate(parameters, composites);
+		results.WriteToCSV("CrossValidationResults.csv", composites);
+		return;
+	}
 
-	// Read in composites filtered to interpolation area and validate
-	Composites composites(compositesFilePath, parameters.BlockParameters.BlockCoordExtents, parameters.MaxRadius);
+	// Create blocks based on input parameters; indicator kriging stores one CCDF column per cutoff
+	Blocks blocks(parameters.BlockParameters, parameters.GetEstimateNames(), parameters.GradePrecision);
 
 	// Perform kriging
 	KrigingEngine::RunKriging(blocks, parameters, composites);
@@ -0,0 +1,84 @@
+#include "Anisotropy.hpp"
+#include "KrigingParameters.hpp"
+
+Anisotropy::Anisotropy(const VariogramParameters& parameters)
+	: Anisotropy(parameters.Range, parameters.RangeSemiMajor, parameters.RangeMinor, parameters.Azimuth, parameters.Dip,
+		parameters.Plunge)
+{
+}
+
+Anisotropy::Anisotropy(double rangeMajor, double rangeSemiMajor, double rangeMinor, double azimuth, double dip, double plunge)
+{
+	// Ranges default to the major range
+	rangeSemiMajor = rangeSemiMajor > 0 ? rangeSemiMajor : rangeMajor;
+	rangeMinor = rangeMinor > 0 ? rangeMinor : rangeMajor;
+
+	// GSLIB rotation angles; azimuth is converted from clockwise from north to counterclockwise from east. Dip is
+	// positive downwards here, where GSLIB's declination is negative downwards.
+	constexpr double degreesToRadians = std::numbers::pi / 180.0;
+	double alpha = azimuth >= 0.0 && azimuth < 270.0
+		? (90.0 - azimuth) * degreesToRadians
+		: (450.0 - azimuth) * degreesToRadians;
+	double beta = dip * degreesToRadians;
+	double theta = plunge * degreesToRadians;
+
+	double sina = sin(alpha), cosa = cos(alpha);
+	double sinb = sin(beta), cosb = cos(beta);
+	double sint = sin(theta), cost = cos(theta);
+
+	// Scale factors of the semi-major and minor axes relative to the major axis
+	double factorSemiMajor = 1.0 / std::max(rangeSemiMajor / rangeMajor, mMinAnisotropyRatio);
+	double factorMinor = 1.0 / std::max(rangeMinor / rangeMajor, mMinAnisotropyRatio);
+
+	mMatrix[0][0] = cosb * cosa;
+	mMatrix[0][1] = cosb * sina;
+	mMatrix[0][2] = -sinb;
+	mMatrix[1][0] = factorSemiMajor * (-cost * sina + sint * sinb * cosa);
+	mMatrix[1][1] = factorSemiMajor * (cost * cosa + sint * sinb * sina);
+	mMatrix[1][2] = factorSemiMajor * (sint * cosb);
+	mMatrix[2][0] = factorMinor * (sint * sina + cost * sinb * cosa);
+	mMatrix[2][1] = factorMinor * (-sint * cosa + cost * sinb * sina);
+	mMatrix[2][2] = factorMinor * (cost * cosb);
+
+	// Equal ranges give a pure rotation, which does not change distances
+	mIsIsotropic = rangeSemiMajor == rangeMajor && rangeMinor == rangeMajor;
+}
+
+Anisotropy Anisotropy::RelativeTo(const Anisotropy& base) const
+{
+	// Inverse of the base matrix from its cofactors
+	const auto& b = base.mMatrix;
+	double inverse[3][3];
+	inverse[0][0] = b[1][1] * b[2][2] - b[1][2] * b[2][1];
+	inverse[0][1] = b[0][2] * b[2][1] - b[0][1] * b[2][2];
+	inverse[0][2] = b[0][1] * b[1][2] - b[0][2] * b[1][1];
+	inverse[1][0] = b[1][2] * b[2][0] - b[1][0] * b[2][2];
+	inverse[1][1] = b[0][0] * b[2][2] - b[0][2] * b[2][0];
+	inverse[1][2] = b[0][2] * b[1][0] - b[0][0] * b[1][2];
+	inverse[2][0] = b[1][0] * b[2][1] - b[1][1] * b[2][0];
+	inverse[2][1] = b[0][1] * b[2][0] - b[0][0] * b[2][1];
+	inverse[2][2] = b[0][0] * b[1][1] - b[0][1] * b[1][0];
+	double determinant = b[0][0] * inverse[0][0] + b[0][1] * inverse[1][0] + b[0][2] * inverse[2][0];
+
+	Anisotropy relative;
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			relative.mMatrix[i][j] = (mMatrix[i][0] * inverse[0][j] + mMatrix[i][1] * inverse[1][j] + mMatrix[i][2] * inverse[2][j]) / determinant;
+		}
+	}
+
+	// Distances are preserved if the relative matrix is orthogonal
+	relative.mIsIsotropic = true;
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			const auto& m = relative.mMatrix;
+			double product = m[0][i] * m[0][j] + m[1][i] * m[1][j] + m[2][i] * m[2][j];
+			relative.mIsIsotropic = relative.mIsIsotropic && std::abs(product - (i == j ? 1.0 : 0.0)) < mIsometryTolerance;
+		}
+	}
+	return relative;
+}
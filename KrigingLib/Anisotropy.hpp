@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cmath>
+#include <numbers>
+#include <algorithm>
+
+class VariogramParameters;
+
+/**
+ * @brief Rotation and scaling from model coordinates into the isotropic space of a variogram.
+ *
+ * Angles follow the GSLIB rotation sequence: azimuth of the major axis clockwise from north (Y), dip of the major
+ * axis, positive below horizontal, and plunge as a rotation about the major axis. Each axis is scaled by the major range over
+ * its own range, so the Euclidean distance between transformed points is the anisotropic lag distance in major
+ * range units, and the isotropic variogram with Range = major range applies directly. The same transform turns a
+ * search ellipsoid into a sphere with the major range as its radius.
+ */
+class Anisotropy
+{
+public:
+	/**
+	 * @brief Identity transform.
+	 */
+	Anisotropy() = default;
+
+	/**
+	 * @brief Builds the transform from the ranges along the major, semi-major and minor axes, and the angles in degrees.
+	 *
+	 * Semi-major and minor ranges of 0 use the major range.
+	 */
+	Anisotropy(double rangeMajor, double rangeSemiMajor, double rangeMinor, double azimuth, double dip, double plunge);
+
+	/**
+	 * @brief Builds the transform from the variogram's angles and ranges.
+	 */
+	explicit Anisotropy(const VariogramParameters& parameters);
+
+	/**
+	 * @brief True if the transform preserves distances, so coordinates need no transformation
+	 */
+	bool IsIsotropic() const { return mIsIsotropic; }
+
+	/**
+	 * @brief Transforms a point into isotropic space.
+	 */
+	void Transform(double x, double y, double z, double& tx, double& ty, double& tz) const
+	{
+		tx = mMatrix[0][0] * x + mMatrix[0][1] * y + mMatrix[0][2] * z;
+		ty = mMatrix[1][0] * x + mMatrix[1][1] * y + mMatrix[1][2] * z;
+		tz = mMatrix[2][0] * x + mMatrix[2][1] * y + mMatrix[2][2] * z;
+	}
+
+	/**
+	 * @brief Returns the transform from the isotropic space of base into the isotropic space of this transform.
+	 *
+	 * The result is isotropic if it preserves distances, e.g. if both transforms share their angles and range ratios.
+	 */
+	Anisotropy RelativeTo(const Anisotropy& base) const;
+
+	/**
+	 * @brief Get element (row, column) of the transform matrix
+	 */
+	double GetElement(int row, int column) const { return mMatrix[row][column]; }
+
+private:
+	double mMatrix[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+	bool mIsIsotropic = true;
+
+	// Smallest anisotropy ratio, to avoid division by zero
+	static constexpr double mMinAnisotropyRatio = 1e-20;
+
+	// Tolerance on M'M - I for a relative transform M to be treated as distance preserving
+	static constexpr double mIsometryTolerance = 1e-12;
+};
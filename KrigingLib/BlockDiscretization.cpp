@@ -0,0 +1,96 @@
+#include "BlockDiscretization.hpp"
+
+BlockDiscretization::BlockDiscretization(const VariogramModel& model)
+	: BlockDiscretization(BlockDiscretizationParameters(), 0.0, 0.0, 0.0, model)
+{
+}
+
+BlockDiscretization::BlockDiscretization(const BlockDiscretizationParameters& parameters, double blockSizeX, double blockSizeY,
+	double blockSizeZ, const VariogramModel& model)
+{
+	// Centres of equal sub-blocks, relative to the block centroid, transformed into isotropic space
+	const Anisotropy& anisotropy = model.GetAnisotropy();
+	size_t numPoints = static_cast<size_t>(parameters.CountI) * parameters.CountJ * parameters.CountK;
+	mOffsetX.reserve(numPoints);
+	mOffsetY.reserve(numPoints);
+	mOffsetZ.reserve(numPoints);
+	for (int k = 0; k < parameters.CountK; ++k)
+	{
+		for (int j = 0; j < parameters.CountJ; ++j)
+		{
+			for (int i = 0; i < parameters.CountI; ++i)
+			{
+				double dx = ((i + 0.5) / parameters.CountI - 0.5) * blockSizeX;
+				double dy = ((j + 0.5) / parameters.CountJ - 0.5) * blockSizeY;
+				double dz = ((k + 0.5) / parameters.CountK - 0.5) * blockSizeZ;
+				double tx, ty, tz;
+				anisotropy.Transform(dx, dy, dz, tx, ty, tz);
+				mOffsetX.push_back(tx);
+				mOffsetY.push_back(ty);
+				mOffsetZ.push_back(tz);
+			}
+		}
+	}
+
+	// C(V,V), averaged over every pair of discretization points; once per run rather than per block. As in GSLIB kt3d,
+	// the nugget is excluded from coincident pairs, so each point with itself contributes the structured sill
+	double sum = numPoints * (model.GetSill() - model.GetNugget());
+	std::vector<double> covariances(numPoints);
+	for (size_t p = 0; p + 1 < numPoints; ++p)
+	{
+		// Distinct pairs (p, q > p), counted twice for (q, p)
+		size_t count = numPoints - p - 1;
+		PointCovariances(mOffsetX[p], mOffsetY[p], mOffsetZ[p], mOffsetX.data() + p + 1, mOffsetY.data() + p + 1,
+			mOffsetZ.data() + p + 1, count, model, covariances.data());
+		for (size_t q = 0; q < count; ++q)
+		{
+			sum += 2.0 * covariances[q];
+		}
+	}
+	mBlockCovariance = sum / (static_cast<double>(numPoints) * numPoints);
+}
+
+void BlockDiscretization::BlockCovariances(double x0, double y0, double z0, const double* xs, const double* ys, const double* zs,
+	size_t n, const VariogramModel& model, double* covariances, double* buffer) const
+{
+	size_t numPoints = GetNumPoints();
+	if (numPoints == 1)
+	{
+		PointCovariances(x0, y0, z0, xs, ys, zs, n, model, covariances);
+		return;
+	}
+
+	std::fill_n(covariances, n, 0.0);
+	for (size_t p = 0; p < numPoints; ++p)
+	{
+		PointCovariances(x0 + mOffsetX[p], y0 + mOffsetY[p], z0 + mOffsetZ[p], xs, ys, zs, n, model, buffer);
+		for (size_t i = 0; i < n; ++i)
+		{
+			covariances[i] += buffer[i];
+		}
+	}
+
+	double scale = 1.0 / numPoints;
+	for (size_t i = 0; i < n; ++i)
+	{
+		covariances[i] *= scale;
+	}
+}
+
+void BlockDiscretization::PointCovariances(double x0, double y0, double z0, const double* xs, const double* ys, const double* zs,
+	size_t n, const VariogramModel& model, double* covariances)
+{
+	// Covariances depend on the lag direction only if nested structures have different anisotropies
+	if (model.IsDistanceOnly())
+	{
+		DistanceKernel::Compute(x0, y0, z0, xs, ys, zs, n, covariances);
+		model.Covariances(covariances, n);
+	}
+	else
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			covariances[i] = model.Covariance(x0 - xs[i], y0 - ys[i], z0 - zs[i]);
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+
+#include "KrigingParameters.hpp"
+#include "VariogramModel.hpp"
+#include "DistanceKernel.hpp"
+
+/**
+ * @brief Block support for block kriging: a stencil of discretization points shared by all blocks of one size.
+ *
+ * The offsets of the discretization points from the block centroid are computed once, in the isotropic space of
+ * the variogram, so the points of any block are its transformed centroid plus the stencil. The average covariance
+ * between two points of a block, C(V,V), depends only on the stencil, so it is also computed once. As in GSLIB,
+ * a point paired with itself contributes the sill less the nugget.
+ *
+ * A single point at the centroid is point support; its sample-block covariances are point covariances and
+ * C(V,V) is the covariance at lag zero.
+ */
+class BlockDiscretization
+{
+public:
+	/**
+	 * @brief Point support.
+	 */
+	explicit BlockDiscretization(const VariogramModel& model);
+
+	/**
+	 * @param blockSizeX,blockSizeY,blockSizeZ Block dimensions in model coordinates.
+	 * @param model Compiled variogram; the stencil is built in its isotropic space.
+	 */
+	BlockDiscretization(const BlockDiscretizationParameters& parameters, double blockSizeX, double blockSizeY, double blockSizeZ,
+		const VariogramModel& model);
+
+	/**
+	 * @brief Get number of discretization points per block
+	 */
+	size_t GetNumPoints() const { return mOffsetX.size(); }
+
+	/**
+	 * @brief Gets the offset of discretization point p from the block centroid, in isotropic space.
+	 */
+	void GetOffset(size_t p, double& x, double& y, double& z) const
+	{
+		x = mOffsetX[p];
+		y = mOffsetY[p];
+		z = mOffsetZ[p];
+	}
+
+	/**
+	 * @brief Get average covariance between the discretization points of a block, C(V,V)
+	 */
+	double GetBlockCovariance() const { return mBlockCovariance; }
+
+	/**
+	 * @brief Computes the average covariance between each sample and the block centred on p0.
+	 *
+	 * Coordinates are in the model's isotropic space. Covariances from each discretization point to all samples
+	 * are computed as one batch, then averaged. Nothing is cached, since each sample's offset from the block
+	 * differs, so the cost is GetNumPoints() times that of point covariances.
+	 *
+	 * @param n Number of samples.
+	 * @param covariances Output, n sample-block covariances.
+	 * @param buffer Scratch space for n values; not used with point support.
+	 */
+	void BlockCovariances(double x0, double y0, double z0, const double* xs, const double* ys, const double* zs, size_t n,
+		const VariogramModel& model, double* covariances, double* buffer) const;
+
+private:
+	std::vector<double> mOffsetX, mOffsetY, mOffsetZ; // Offsets of the discretization points from the centroid, in isotropic space
+	double mBlockCovariance = 0.0;
+
+	/**
+	 * @brief Computes the covariance between point p0 and each of n samples.
+	 */
+	static void PointCovariances(double x0, double y0, double z0, const double* xs, const double* ys, const double* zs, size_t n,
+		const VariogramModel& model, double* covariances);
+};
@@ -1,41 +1,41 @@
 #include "Blocks.hpp"
 
-Blocks::Blocks(const BlockModelInfo& modelInfo)
+GradeColumn::GradeColumn(size_t size, KrigingParameters::PrecisionType precision)
+	: mPrecision(precision)
+{
+	if (mPrecision == KrigingParameters::PrecisionType::Float)
+	{
+		mFloatValues.assign(size, std::numeric_limits<float>::quiet_NaN());
+	}
+	else
+	{
+		mDoubleValues.assign(size, std::numeric_limits<double>::quiet_NaN());
+	}
+}
+
+Blocks::Blocks(const BlockModelInfo& modelInfo, const std::vector<std::string>& variableNames,
+	KrigingParameters::PrecisionType precision)
+	: mVariableNames(variableNames)
 {
 	std::cout << "Generating blocks..." << std::endl;
 
 	auto extents = modelInfo.BlockCoordExtents;
 
-	double deltaX = (extents.MaxX - extents.MinX) / modelInfo.BlockCountI;
-	double deltaY = (extents.MaxY - extents.MinY) / modelInfo.BlockCountJ;
-	double deltaZ = (extents.MaxZ - extents.MinZ) / modelInfo.BlockCountK;
+	mMinX = extents.MinX;
+	mMinY = extents.MinY;
+	mMinZ = extents.MinZ;
+	mDeltaX = (extents.MaxX - extents.MinX) / modelInfo.BlockCountI;
+	mDeltaY = (extents.MaxY - extents.MinY) / modelInfo.BlockCountJ;
+	mDeltaZ = (extents.MaxZ - extents.MinZ) / modelInfo.BlockCountK;
 
-	int numBlocks = modelInfo.BlockCountI * modelInfo.BlockCountJ * modelInfo.BlockCountK;
+	mCountI = static_cast<size_t>(modelInfo.BlockCountI);
+	mCountJ = static_cast<size_t>(modelInfo.BlockCountJ);
+	mCountIJ = mCountI * mCountJ;
+	mNumBlocks = mCountIJ * static_cast<size_t>(modelInfo.BlockCountK);
 
-	X.reserve(numBlocks);
-	Y.reserve(numBlocks);
-	Z.reserve(numBlocks);
-	Grade.resize(numBlocks, std::nullopt); // Initialize grade with null values
+	Grades.assign(mVariableNames.size(), GradeColumn(mNumBlocks, precision)); // Initialize grades as not estimated
 
-	for (int k = 0; k < modelInfo.BlockCountK; ++k)
-	{
-		double z = extents.MinZ + k * deltaZ + deltaZ / 2.0;
-
-		for (int j = 0; j < modelInfo.BlockCountJ; ++j)
-		{
-			double y = extents.MinY + j * deltaY + deltaY / 2.0;
-
-			for (int i = 0; i < modelInfo.BlockCountI; ++i)
-			{
-				double x = extents.MinX + i * deltaX + deltaX / 2.0;
-
-				X.emplace_back(x);
-				Y.emplace_back(y);
-				Z.emplace_back(z);
-			}
-		}
-	}
-	std::cout << "Number of blocks created: " << X.size() << std::endl;
+	std::cout << "Number of blocks created: " << mNumBlocks << std::endl;
 }
 
 void Blocks::WriteToCSV(const std::string& filePath) const
@@ -47,21 +47,49 @@ void Blocks::WriteToCSV(const std::string& filePath) const
 		LogAndThrow<std::runtime_error>("Cannot write to file: " + filePath);
 	}
 
-	file << "X,Y,Z,Grade\n";
+	file << "X,Y,Z";
+	for (const auto& variableName : mVariableNames)
+	{
+		file << "," << variableName;
+	}
+	if (HasDiagnostics())
+	{
+		file << ",KrigingVariance,SlopeOfRegression,NumSamples,AverageDistance,SumNegativeWeights";
+	}
+	file << "\n";
 
 	size_t numRows = GetSize();
+	size_t numVariables = GetNumVariables();
 	std::string grade;
 	for (size_t i = 0; i < numRows; ++i)
 	{
-		if (Grade[i].has_value())
+		file << GetX(i) << "," << GetY(i) << "," << GetZ(i);
+		for (size_t v = 0; v < numVariables; ++v)
 		{
-			grade = std::to_string(Grade[i].value());
+			if (Grades[v].HasValue(i))
+			{
+				grade = std::to_string(Grades[v].GetValue(i));
+			}
+			else
+			{
+				grade = "NULL";
+			}
+			file << "," << grade;
 		}
-		else
+		if (HasDiagnostics())
 		{
-			grade = "NULL";
+			const auto& diagnostics = Diagnostics[i];
+			if (std::isnan(diagnostics.KrigingVariance))
+			{
+				file << ",NULL,NULL," << diagnostics.NumSamples << ",NULL,NULL";
+			}
+			else
+			{
+				file << "," << diagnostics.KrigingVariance << "," << diagnostics.SlopeOfRegression << ","
+					<< diagnostics.NumSamples << "," << diagnostics.AverageDistance << "," << diagnostics.SumNegativeWeights;
+			}
 		}
-		file << X[i] << "," << Y[i] << "," << Z[i] << "," << grade << "\n";
+		file << "\n";
 	}
 
 	file.close();
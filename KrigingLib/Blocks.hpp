@@ -1,54 +1,201 @@
 #pragma once
 
 #include <vector>
+#include <optional>
+#include <limits>
+#include <cmath>
 
 #include "KrigingParameters.hpp"
 
+/**
+ * @brief Kriging diagnostics for one block, derived from the solved kriging system.
+ *
+ * Values other than NumSamples are NaN if the block was not estimated.
+ */
+struct KrigingDiagnostics
+{
+	double KrigingVariance = std::numeric_limits<double>::quiet_NaN(); // Kriging (estimation) variance
+	double SlopeOfRegression = std::numeric_limits<double>::quiet_NaN(); // Slope of regression of true on estimated values
+	size_t NumSamples = 0; // Number of composites found in the search neighbourhood
+	double AverageDistance = std::numeric_limits<double>::quiet_NaN(); // Average search distance from the block to the composites; anisotropic for a search ellipsoid
+	double SumNegativeWeights = std::numeric_limits<double>::quiet_NaN(); // Sum of negative kriging weights
+};
+
+/**
+ * @brief Compact storage for one column of block grades.
+ *
+ * Grades are stored as a plain double or float array, with NaN marking blocks that were not estimated.
+ * Unlike a bitset, the NaN sentinel lets threads write neighbouring blocks without synchronization.
+ */
+class GradeColumn
+{
+public:
+	/**
+	 * @brief Initializes size grades as not estimated.
+	 */
+	GradeColumn(size_t size, KrigingParameters::PrecisionType precision);
+
+	/**
+	 * @brief Get grade at block index i, or nullopt if not estimated
+	 */
+	std::optional<double> operator[](size_t i) const
+	{
+		double value = GetValue(i);
+		return std::isnan(value) ? std::nullopt : std::optional<double>(value);
+	}
+
+	/**
+	 * @brief Get grade at block index i; NaN if not estimated
+	 */
+	double GetValue(size_t i) const
+	{
+		return mPrecision == KrigingParameters::PrecisionType::Float ? mFloatValues[i] : mDoubleValues[i];
+	}
+
+	/**
+	 * @brief Returns true if block index i was estimated
+	 */
+	bool HasValue(size_t i) const { return !std::isnan(GetValue(i)); }
+
+	/**
+	 * @brief Set grade at block index i
+	 */
+	void Set(size_t i, double value)
+	{
+		if (mPrecision == KrigingParameters::PrecisionType::Float)
+		{
+			mFloatValues[i] = static_cast<float>(value);
+		}
+		else
+		{
+			mDoubleValues[i] = value;
+		}
+	}
+
+	/**
+	 * @brief Mark block index i as not estimated
+	 */
+	void Reset(size_t i) { Set(i, std::numeric_limits<double>::quiet_NaN()); }
+
+	/**
+	 * @brief Get storage precision
+	 */
+	KrigingParameters::PrecisionType GetPrecision() const { return mPrecision; }
+
+	/**
+	 * @brief Get raw grades; only valid for double precision storage
+	 */
+	const std::vector<double>& GetDoubleValues() const { return mDoubleValues; }
+
+	/**
+	 * @brief Get raw grades; only valid for float precision storage
+	 */
+	const std::vector<float>& GetFloatValues() const { return mFloatValues; }
+
+private:
+	KrigingParameters::PrecisionType mPrecision;
+	std::vector<double> mDoubleValues; // Used for double precision only
+	std::vector<float> mFloatValues; // Used for float precision only
+};
+
 /**
  * @brief Class containing block model information.
+ *
+ * Blocks form an implicit regular grid: centroids are computed on demand from the block's (i,j,k) grid
+ * position, with i varying fastest, so only the estimates are stored per block.
  */
 class Blocks
 {
 public:
-	std::vector<std::optional<double>> Grade; // Block grades
+	std::vector<GradeColumn> Grades; // Block grades per variable; Grades[v][i] is variable v at block i
+	std::vector<KrigingDiagnostics> Diagnostics; // Optional kriging diagnostics per block; empty unless enabled
 
 	/**
-	 * @brief Initializes block locations based on input model information.
+	 * @brief Initializes the block grid based on input model information.
 	 * 
 	 * NOTE: Assumes data have been previously validated. 
      * Refer to KrigingParameters class for validation.
+	 * 
+	 * @param modelInfo Block model definition.
+	 * @param variableNames Names of the estimated variables; one grade column is stored per variable.
+	 * @param precision Storage precision of the grade columns.
+	 */
+	Blocks(const BlockModelInfo& modelInfo, const std::vector<std::string>& variableNames = { "Grade" },
+		KrigingParameters::PrecisionType precision = KrigingParameters::PrecisionType::Double);
+
+	/**
+	 * @brief Get X centroid of block index i
+	 */
+	double GetX(size_t i) const { return mMinX + (i % mCountI) * mDeltaX + mDeltaX / 2.0; }
+
+	/**
+	 * @brief Get Y centroid of block index i
+	 */
+	double GetY(size_t i) const { return mMinY + ((i / mCountI) % mCountJ) * mDeltaY + mDeltaY / 2.0; }
+
+	/**
+	 * @brief Get Z centroid of block index i
+	 */
+	double GetZ(size_t i) const { return mMinZ + (i / mCountIJ) * mDeltaZ + mDeltaZ / 2.0; }
+
+	/**
+	 * @brief Get number of blocks
+	 */
+	size_t GetSize() const { return mNumBlocks; }
+
+	/**
+	 * @brief Get number of blocks in the i, j and k directions
+	 */
+	size_t GetCountI() const { return mCountI; }
+	size_t GetCountJ() const { return mCountJ; }
+	size_t GetCountK() const { return mNumBlocks / mCountIJ; }
+
+	/**
+	 * @brief Get block index of grid position (i,j,k)
+	 */
+	size_t GetIndex(size_t i, size_t j, size_t k) const { return i + j * mCountI + k * mCountIJ; }
+
+	/**
+	 * @brief Get block sizes in the X, Y and Z directions
 	 */
-	Blocks(const BlockModelInfo& modelInfo);
+	double GetBlockSizeX() const { return mDeltaX; }
+	double GetBlockSizeY() const { return mDeltaY; }
+	double GetBlockSizeZ() const { return mDeltaZ; }
 
 	/**
-	 * @brief Get X value at composite index i
+	 * @brief Get number of estimated variables
 	 */
-	double GetX(size_t i) const { return X[i]; }
+	size_t GetNumVariables() const { return mVariableNames.size(); }
 
 	/**
-	 * @brief Get Y value at composite index i
+	 * @brief Get estimated variable names
 	 */
-	double GetY(size_t i) const { return Y[i]; }
+	const std::vector<std::string>& GetVariableNames() const { return mVariableNames; }
 
 	/**
-	 * @brief Get Z value at composite index i
+	 * @brief Allocates diagnostics output for every block
 	 */
-	double GetZ(size_t i) const { return Z[i]; }
+	void EnableDiagnostics() { Diagnostics.assign(GetSize(), KrigingDiagnostics()); }
 
 	/**
-	 * @brief Get number of composites
+	 * @brief Returns true if diagnostics output is enabled
 	 */
-	size_t GetSize() const { return X.size(); }
+	bool HasDiagnostics() const { return !Diagnostics.empty(); }
 
 	/**
-	 * @brief Writes blocks to CSV at the provided filepath
+	 * @brief Writes blocks to CSV at the provided filepath, including diagnostics if enabled
 	 */
 	void WriteToCSV(const std::string& filePath) const;
 
 private:
-	std::vector<double> X, Y, Z; // Block centroids; can only be set in the constructor
+	// Grid definition; can only be set in the constructor
+	double mMinX, mMinY, mMinZ; // Minimum grid coordinates
+	double mDeltaX, mDeltaY, mDeltaZ; // Block sizes
+	size_t mCountI, mCountJ, mCountIJ; // Block counts in the i and j directions, and per k level
+	size_t mNumBlocks;
+	std::vector<std::string> mVariableNames; // Estimated variable names, one per grade column
 };
 
 //TODO: Add domain and read in blocks from file for geology matching
 
-//TODO: Refactor this depending on future block model file format and I/O TBC; for now storing blocks in memory
+//TODO: Refactor this depending on future block model file format and I/O TBC; for now storing estimates in memory
@@ -1,13 +1,52 @@
 #include "Composites.hpp"
 
-Composites::Composites(const std::string& csvFilePath, const CoordinateExtents& blockExtents, double maxSearchRadius)
+Composites::Composites(const std::string& csvFilePath, const CoordinateExtents& blockExtents, double maxSearchRadius,
+	const std::vector<std::string>& variableNames, size_t numThreads, bool useCache, size_t kdTreeLeafSize,
+	const Anisotropy& searchAnisotropy)
+	: mVariableNames(variableNames), mSearchAnisotropy(searchAnisotropy), mKdTreeLeafSize(kdTreeLeafSize), mNumThreads(numThreads)
 {
-	ReadCompositesFromCSV(csvFilePath, blockExtents, maxSearchRadius);
+	std::string cachePath = csvFilePath + mCacheExtension;
+	bool loadedFromCache = false;
+	if (useCache)
+	{
+		mSourceKey = ComputeSourceKey(csvFilePath, blockExtents, maxSearchRadius);
+		loadedFromCache = mSourceKey != 0 && std::filesystem::exists(cachePath) && ReadCompositesFromBinary(cachePath, mSourceKey);
+		if (loadedFromCache)
+		{
+			std::cout << "Loaded " << X.size() << " composites from cache: " << cachePath << std::endl;
+		}
+	}
+
+	if (!loadedFromCache)
+	{
+		ReadCompositesFromCSV(csvFilePath, blockExtents, maxSearchRadius, numThreads);
+	}
 	FinishInitialization();
+
+	// The cache only saves work for later runs, so failing to write it does not fail this one
+	if (useCache && !loadedFromCache && mSourceKey != 0)
+	{
+		try
+		{
+			SaveBinary(cachePath);
+		}
+		catch (const std::runtime_error&)
+		{
+			std::cout << "Warning: Composites cache not written; continuing without it" << std::endl;
+		}
+	}
 }
 
 Composites::Composites(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, const std::vector<double>& grades)
-	: X(x), Y(y), Z(z), Grade(grades)
+	: X(x), Y(y), Z(z), Values({ grades }), mVariableNames({ "Grade" })
+{
+	FinishInitialization();
+}
+
+Composites::Composites(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z,
+	const std::vector<std::vector<double>>& values, const std::vector<std::string>& variableNames,
+	const Anisotropy& searchAnisotropy)
+	: X(x), Y(y), Z(z), Values(values), mVariableNames(variableNames), mSearchAnisotropy(searchAnisotropy)
 {
 	FinishInitialization();
 }
@@ -17,32 +56,406 @@ Composites::~Composites()
 	delete mKdTree;
 }
 
+std::unique_ptr<Composites> Composites::LoadBinary(const std::string& filePath)
+{
+	std::unique_ptr<Composites> composites(new Composites());
+	if (!composites->ReadCompositesFromBinary(filePath, std::nullopt))
+	{
+		LogAndThrow<std::runtime_error>("Invalid composite binary file: " + filePath);
+	}
+	composites->FinishInitialization();
+	return composites;
+}
+
+void Composites::SaveBinary(const std::string& filePath) const
+{
+	static_assert(std::endian::native == std::endian::little, "Binary composite files are little-endian");
+
+	// Write a uniquely named temporary file and rename it over the destination once complete, so processes
+	// sharing the file, possibly memory mapped, never see it truncated or partly written
+	std::string tempPath = filePath + ".tmp" + std::to_string(std::random_device()());
+	std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		LogAndThrow<std::runtime_error>("Cannot write to file: " + tempPath);
+	}
+
+	// Variable names block, padded so the columns are 8 byte aligned
+	std::string names;
+	for (const auto& variableName : mVariableNames)
+	{
+		names.append(variableName);
+		names.push_back('\0');
+	}
+	names.resize((names.size() + 7) / 8 * 8, '\0');
+
+	BinaryHeader header = {};
+	std::memcpy(header.Magic, mBinaryMagic, sizeof(header.Magic));
+	header.Version = mBinaryVersion;
+	header.NumVariables = static_cast<uint32_t>(mVariableNames.size());
+	header.NumComposites = X.size();
+	header.SourceKey = mSourceKey;
+	header.NamesBytes = names.size();
+
+	// The index size and key are only known once the index is written, so the header is rewritten after it
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(names.data(), names.size());
+	auto writeColumn = [&file](const std::vector<double>& column) {
+		file.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(double));
+	};
+	writeColumn(X);
+	writeColumn(Y);
+	writeColumn(Z);
+	for (const auto& values : Values)
+	{
+		writeColumn(values);
+	}
+
+	// Stream the kd-tree index straight to the file, hashing the bytes as they are written
+	HashingStreamBuffer indexBuffer(file.rdbuf(), ComputeSearchCoordinatesKey());
+	std::ostream indexStream(&indexBuffer);
+	mKdTree->saveIndex(indexStream);
+	indexStream.flush();
+	if (!indexStream)
+	{
+		file.setstate(std::ios::badbit);
+	}
+	header.IndexBytes = indexBuffer.NumBytes;
+	header.IndexKey = indexBuffer.Key;
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	file.close();
+	std::error_code error;
+	if (!file.good())
+	{
+		std::filesystem::remove(tempPath, error);
+		LogAndThrow<std::runtime_error>("Error writing to file: " + tempPath);
+	}
+	std::filesystem::rename(tempPath, filePath, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		LogAndThrow<std::runtime_error>("Cannot replace file: " + filePath);
+	}
+}
+
+bool Composites::ReadCompositesFromBinary(const std::string& filePath, std::optional<uint64_t> expectedSourceKey)
+{
+	MappedFile file(filePath);
+	const char* data = file.GetData();
+	size_t size = file.GetSize();
+
+	// Validate header
+	BinaryHeader header;
+	if (size < sizeof(header))
+	{
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.Magic, mBinaryMagic, sizeof(header.Magic)) != 0 || header.Version != mBinaryVersion)
+	{
+		return false;
+	}
+	if (expectedSourceKey.has_value() && header.SourceKey != expectedSourceKey.value())
+	{
+		return false;
+	}
+
+	// Validate size; the file must hold exactly the names block, all columns and the index
+	if (header.NamesBytes > size - sizeof(header) || header.NumVariables > header.NamesBytes)
+	{
+		return false;
+	}
+	size_t numColumns = 3 + static_cast<size_t>(header.NumVariables);
+	size_t columnsOffset = sizeof(header) + header.NamesBytes;
+	if (header.IndexBytes > size - columnsOffset)
+	{
+		return false;
+	}
+	size_t columnsBytes = size - columnsOffset - header.IndexBytes;
+	size_t rowBytes = numColumns * sizeof(double);
+	if (columnsBytes % rowBytes != 0 || columnsBytes / rowBytes != header.NumComposites)
+	{
+		return false;
+	}
+
+	// Read variable names
+	std::vector<std::string> variableNames;
+	const char* name = data + sizeof(header);
+	const char* namesEnd = data + columnsOffset;
+	for (uint32_t v = 0; v < header.NumVariables; ++v)
+	{
+		const char* nameEnd = std::find(name, namesEnd, '\0');
+		if (nameEnd == namesEnd)
+		{
+			return false;
+		}
+		variableNames.emplace_back(name, nameEnd);
+		name = nameEnd + 1;
+	}
+	if (expectedSourceKey.has_value() && variableNames != mVariableNames)
+	{
+		return false;
+	}
+
+	// Copy columns
+	size_t numComposite = header.NumComposites;
+	const char* column = data + columnsOffset;
+	auto readColumn = [&column, numComposite](std::vector<double>& values) {
+		values.resize(numComposite);
+		std::memcpy(values.data(), column, numComposite * sizeof(double));
+		column += numComposite * sizeof(double);
+	};
+	readColumn(X);
+	readColumn(Y);
+	readColumn(Z);
+	Values.assign(header.NumVariables, {});
+	for (auto& values : Values)
+	{
+		readColumn(values);
+	}
+
+	mVariableNames = variableNames;
+	mSourceKey = header.SourceKey;
+
+	// Reuse the stored index if it matches the search coordinates; otherwise the kd-tree is built as usual
+	InitializeSearchCoordinates();
+	if (header.IndexBytes > 0 && !LoadKdTree(column, column + header.IndexBytes, header.IndexKey))
+	{
+		std::cout << "Stored kd-tree index does not match the composites and will be rebuilt: " << filePath << std::endl;
+	}
+	return true;
+}
+
+bool Composites::LoadKdTree(const char* begin, const char* end, uint64_t indexKey)
+{
+	if (ComputeIndexKey(begin, end) != indexKey)
+	{
+		return false;
+	}
+
+	MemoryStreamBuffer buffer(begin, end);
+	std::istream stream(&buffer);
+	mKdTree = new KDTree(3, *this, nanoflann::KDTreeSingleIndexAdaptorParams(mKdTreeLeafSize,
+		nanoflann::KDTreeSingleIndexAdaptorFlags::SkipInitialBuildIndex));
+	mKdTree->loadIndex(stream);
+
+	// The whole index must be read, and it must index every composite
+	if (!stream || stream.peek() != std::char_traits<char>::eof() || mKdTree->size_ != X.size() || mKdTree->vAcc_.size() != X.size())
+	{
+		delete mKdTree;
+		mKdTree = nullptr;
+		return false;
+	}
+	return true;
+}
+
+uint64_t Composites::ComputeIndexKey(const char* begin, const char* end) const
+{
+	uint64_t key = ComputeSearchCoordinatesKey();
+	HashBytes(key, begin, end - begin);
+	return key;
+}
+
+uint64_t Composites::ComputeSearchCoordinatesKey() const
+{
+	uint64_t key = 14695981039346656037ull;
+	size_t numBytes = X.size() * sizeof(double);
+	HashBytes(key, mSearchX, numBytes);
+	HashBytes(key, mSearchY, numBytes);
+	HashBytes(key, mSearchZ, numBytes);
+	return key;
+}
+
+void Composites::HashBytes(uint64_t& key, const void* data, size_t numBytes)
+{
+	const char* bytes = static_cast<const char*>(data);
+	uint64_t word;
+	size_t i = 0;
+	for (; i + sizeof(word) <= numBytes; i += sizeof(word))
+	{
+		std::memcpy(&word, bytes + i, sizeof(word));
+		key = (key ^ word) * 1099511628211ull;
+	}
+	for (; i < numBytes; ++i)
+	{
+		key = (key ^ static_cast<unsigned char>(bytes[i])) * 1099511628211ull;
+	}
+}
+
+uint64_t Composites::ComputeSourceKey(const std::string& filePath, const CoordinateExtents& blockExtents, double maxSearchRadius) const
+{
+	std::error_code error;
+	uint64_t fileSize = std::filesystem::file_size(filePath, error);
+	if (error)
+	{
+		return 0;
+	}
+	auto modifiedTime = std::filesystem::last_write_time(filePath, error).time_since_epoch().count();
+	if (error)
+	{
+		return 0;
+	}
+
+	// Hash of the file and import settings
+	uint64_t key = 14695981039346656037ull;
+	HashBytes(key, &mBinaryVersion, sizeof(mBinaryVersion));
+	HashBytes(key, &fileSize, sizeof(fileSize));
+	HashBytes(key, &modifiedTime, sizeof(modifiedTime));
+	double settings[7] = { blockExtents.MinX, blockExtents.MinY, blockExtents.MinZ,
+		blockExtents.MaxX, blockExtents.MaxY, blockExtents.MaxZ, maxSearchRadius };
+	HashBytes(key, settings, sizeof(settings));
+	HashBytes(key, &mKdTreeLeafSize, sizeof(mKdTreeLeafSize));
+	for (int row = 0; row < 3; ++row)
+	{
+		for (int column = 0; column < 3; ++column)
+		{
+			double element = mSearchAnisotropy.GetElement(row, column);
+			HashBytes(key, &element, sizeof(element));
+		}
+	}
+	for (const auto& variableName : mVariableNames)
+	{
+		HashBytes(key, variableName.c_str(), variableName.size() + 1);
+	}
+
+	// 0 is reserved for unknown sources
+	return key != 0 ? key : 1;
+}
+
 NearestCompositesResult Composites::FindNearestComposites(double x, double y, double z, int n, double maxDist) const
 {
-	// TODO: Optimize this method and nanoflann parameters for improved performance, move reusable objects to the thread level, consider search by maxDist rather than n
+	NearestCompositesResult result;
+	FindNearestComposites(x, y, z, n, maxDist, result);
+	return result;
+}
 
-	double point[3] = { x, y, z };
+void Composites::FindNearestComposites(double x, double y, double z, int n, double maxDist, NearestCompositesResult& result) const
+{
+	double point[3];
+	TransformSearchPoint(x, y, z, point);
 	double maxDistSq = maxDist * maxDist;
 
-	// Perform the nearest neighbor search
-	std::vector<size_t> indices(n);
-	std::vector<double> distancesSq(n);
-	nanoflann::KNNResultSet<double> resultSet(n);
-	resultSet.init(indices.data(), distancesSq.data());
+	// Perform the nearest neighbor search directly into the result buffers. The result set is bounded by maxDist
+	// from the start, so the tree prunes branches beyond it instead of walking far away to find n neighbours in
+	// sparse areas.
+	result.Indices.resize(n);
+	result.Distances.resize(n);
+	nanoflann::RKNNResultSet<double> resultSet(n, SearchBoundSq(maxDistSq));
+	resultSet.init(result.Indices.data(), result.Distances.data());
 	mKdTree->findNeighbors(resultSet, &point[0]);
 
-	// Filter out distances greater than maxDist
-	NearestCompositesResult result;
-	for (size_t i = 0; i < indices.size(); ++i)
+	TrimNearestResult(resultSet.size(), maxDistSq, result);
+}
+
+void Composites::FindNeighbouringComposites(size_t i, int n, double maxDist, NearestCompositesResult& result) const
+{
+	// Search from the composite's own search coordinates, which are already transformed
+	double point[3] = { mSearchX[i], mSearchY[i], mSearchZ[i] };
+	double maxDistSq = maxDist * maxDist;
+
+	result.Indices.resize(n);
+	result.Distances.resize(n);
+	ExcludingResultSet resultSet(n, SearchBoundSq(maxDistSq), i);
+	resultSet.init(result.Indices.data(), result.Distances.data());
+	mKdTree->findNeighbors(resultSet, &point[0]);
+
+	TrimNearestResult(resultSet.size(), maxDistSq, result);
+}
+
+void Composites::FindCandidateComposites(double x, double y, double z, double radius, CompositeCandidates& candidates) const
+{
+	double point[3];
+	TransformSearchPoint(x, y, z, point);
+
+	// Radius search uses squared distances; candidates do not need to be sorted
+	candidates.Matches.clear();
+	mKdTree->radiusSearch(&point[0], radius * radius, candidates.Matches, nanoflann::SearchParameters(0, false));
+
+	// Gather candidate search coordinates
+	size_t numCandidates = candidates.Matches.size();
+	candidates.Indices.resize(numCandidates);
+	candidates.X.resize(numCandidates);
+	candidates.Y.resize(numCandidates);
+	candidates.Z.resize(numCandidates);
+	for (size_t i = 0; i < numCandidates; ++i)
 	{
-		if (distancesSq[i] <= maxDistSq)
+		size_t index = candidates.Matches[i].first;
+		candidates.Indices[i] = index;
+		candidates.X[i] = mSearchX[index];
+		candidates.Y[i] = mSearchY[index];
+		candidates.Z[i] = mSearchZ[index];
+	}
+}
+
+void Composites::FindNearestCandidates(double x, double y, double z, int n, double maxDist,
+	const CompositeCandidates& candidates, NearestCompositesResult& result) const
+{
+	double point[3];
+	TransformSearchPoint(x, y, z, point);
+	double maxDistSq = maxDist * maxDist;
+
+	result.Indices.resize(n);
+	result.Distances.resize(n);
+	nanoflann::RKNNResultSet<double> resultSet(n, SearchBoundSq(maxDistSq));
+	resultSet.init(result.Indices.data(), result.Distances.data());
+
+	// Linear scan of the candidates, keeping the nearest n within maxDist in sorted order
+	size_t numCandidates = candidates.Indices.size();
+	for (size_t i = 0; i < numCandidates; ++i)
+	{
+		double d0 = point[0] - candidates.X[i];
+		double d1 = point[1] - candidates.Y[i];
+		double d2 = point[2] - candidates.Z[i];
+		double distanceSq = d0 * d0 + d1 * d1 + d2 * d2;
+		if (distanceSq < resultSet.worstDist())
 		{
-			result.Indices.push_back(indices[i]);
-			result.Distances.push_back(sqrt(distancesSq[i]));
+			resultSet.addPoint(distanceSq, candidates.Indices[i]);
 		}
 	}
 
-	return result;
+	TrimNearestResult(resultSet.size(), maxDistSq, result);
+}
+
+double Composites::GetSearchDistance(double dx, double dy, double dz) const
+{
+	double offset[3];
+	TransformSearchPoint(dx, dy, dz, offset);
+	return sqrt(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]);
+}
+
+void Composites::TransformSearchPoint(double x, double y, double z, double point[3]) const
+{
+	if (mSearchAnisotropy.IsIsotropic())
+	{
+		point[0] = x;
+		point[1] = y;
+		point[2] = z;
+	}
+	else
+	{
+		mSearchAnisotropy.Transform(x, y, z, point[0], point[1], point[2]);
+	}
+}
+
+double Composites::SearchBoundSq(double maxDistSq)
+{
+	// Result sets only accept distances strictly below their bound; composites at exactly maxDist are included
+	return std::nextafter(maxDistSq, std::numeric_limits<double>::infinity());
+}
+
+void Composites::TrimNearestResult(size_t numFound, double maxDistSq, NearestCompositesResult& result)
+{
+	// Results are sorted by distance and all within the search bound; keep those within maxDist
+	size_t numKept = 0;
+	while (numKept < numFound && result.Distances[numKept] <= maxDistSq)
+	{
+		result.Distances[numKept] = sqrt(result.Distances[numKept]);
+		++numKept;
+	}
+	result.Indices.resize(numKept);
+	result.Distances.resize(numKept);
 }
 
 // Add the required methods for Nanoflann
@@ -53,33 +466,39 @@ inline size_t Composites::kdtree_get_point_count() const
 
 inline double Composites::kdtree_distance(const double* p1, size_t idxp2) const
 {
-	double d0 = p1[0] - X[idxp2];
-	double d1 = p1[1] - Y[idxp2];
-	double d2 = p1[2] - Z[idxp2];
+	double d0 = p1[0] - mSearchX[idxp2];
+	double d1 = p1[1] - mSearchY[idxp2];
+	double d2 = p1[2] - mSearchZ[idxp2];
 	return d0 * d0 + d1 * d1 + d2 * d2;
 }
 
 inline double Composites::kdtree_get_pt(size_t idx, int dim) const
 {
-	if (dim == 0) return X[idx];
-	if (dim == 1) return Y[idx];
-	return Z[idx];
+	if (dim == 0) return mSearchX[idx];
+	if (dim == 1) return mSearchY[idx];
+	return mSearchZ[idx];
 }
 
-void Composites::ReadCompositesFromCSV(const std::string& filePath, const CoordinateExtents& blockExtents, double maxSearchRadius)
+void Composites::ReadCompositesFromCSV(const std::string& filePath, const CoordinateExtents& blockExtents, double maxSearchRadius,
+	size_t numThreads)
 {
 	std::cout << "Reading composites from file: " << filePath << std::endl;
 
-	std::ifstream file(filePath);
-	if (!file)
-	{
-		LogAndThrow<std::runtime_error>("File does not exist or cannot be opened: " + filePath);
-	}
-
-	std::string line;
+	// Map the file and parse it in place
+	MappedFile file(filePath);
+	const char* begin = file.GetData();
+	const char* end = begin + file.GetSize();
 
 	// Read header line
-	std::getline(file, line);
+	const char* headerEnd = FindLineEnd(begin, end);
+	std::string line(begin, headerEnd);
+
+	// Required columns are the coordinates plus one column per variable
+	std::vector<std::string> requiredColumns = { mXColName, mYColName, mZColName };
+	for (const auto& variableName : mVariableNames)
+	{
+		requiredColumns.push_back(ToLower(variableName));
+	}
 
 	// Parse header
 	std::unordered_map<std::string, size_t> columnIndices;
@@ -92,10 +511,10 @@ void Composites::ReadCompositesFromCSV(const std::string& filePath, const Coordi
 	{
 		// Trim whitespace and convert to lowercase for consistency
 		header.erase(header.find_last_not_of(" \n\r\t") + 1);
-		std::transform(header.begin(), header.end(), header.begin(), tolower);
+		header = ToLower(header);
 
 		// Check if the column is one of the required columns
-		if (std::find(mRequiredColumns.begin(), mRequiredColumns.end(), header) != mRequiredColumns.end())
+		if (std::find(requiredColumns.begin(), requiredColumns.end(), header) != requiredColumns.end())
 		{
 			columnIndices[header] = columnIndex;
 		}
@@ -103,11 +522,10 @@ void Composites::ReadCompositesFromCSV(const std::string& filePath, const Coordi
 	}
 
 	// Ensure all required columns are present
-	for (const auto& col : mRequiredColumns)
+	for (const auto& col : requiredColumns)
 	{
 		if (columnIndices.find(col) == columnIndices.end())
 		{
-			file.close();
 			LogAndThrow<std::invalid_argument>("Missing required column: " + col);
 		}
 	}
@@ -122,89 +540,203 @@ void Composites::ReadCompositesFromCSV(const std::string& filePath, const Coordi
 	extents.MaxZ = blockExtents.MaxZ + maxSearchRadius;
 	extents.MinZ = blockExtents.MinZ - maxSearchRadius;
 
-	ReadComposites(file, columnIndices, extents);
-
-	file.close();
+	// Data starts after the header line
+	const char* dataBegin = headerEnd < end ? headerEnd + 1 : end;
+	ReadComposites(dataBegin, end, columnIndices, extents, numThreads);
 }
 
-void Composites::ReadComposites(std::ifstream& file, std::unordered_map<std::string, size_t>& columnIndices, const CoordinateExtents& extents)
+void Composites::ReadComposites(const char* begin, const char* end, std::unordered_map<std::string, size_t>& columnIndices,
+	const CoordinateExtents& extents, size_t numThreads)
 {
-	// Read data
-	std::string line;
-	size_t invalidRows = 0;
-	size_t irrelevantRows = 0;
-	size_t xCol = columnIndices[mXColName];
-	size_t yCol = columnIndices[mYColName];
-	size_t zCol = columnIndices[mZColName];
-	size_t gradeCol = columnIndices[mGradeColName];
-	double x, y, z, grade;
-	while (std::getline(file, line))
+	size_t numVariables = mVariableNames.size();
+
+	// Slot of each CSV column in the parsed row: x, y, z, then one per variable; -1 if the column is not used.
+	// Columns after the last required column are never tokenised.
+	size_t lastColumn = 0;
+	for (const auto& column : columnIndices)
 	{
-		std::istringstream lineStream(line);
-		std::string cell;
-		std::vector<std::string> cells;
+		lastColumn = std::max(lastColumn, column.second);
+	}
+	std::vector<int> columnSlots(lastColumn + 1, -1);
+	columnSlots[columnIndices[mXColName]] = 0;
+	columnSlots[columnIndices[mYColName]] = 1;
+	columnSlots[columnIndices[mZColName]] = 2;
+	for (size_t v = 0; v < numVariables; ++v)
+	{
+		columnSlots[columnIndices[ToLower(mVariableNames[v])]] = static_cast<int>(3 + v);
+	}
 
-		while (std::getline(lineStream, cell, ','))
+	// Split the data into byte ranges, with each boundary moved to the start of the next line
+	size_t numChunks = std::max<size_t>(1, (static_cast<size_t>(end - begin) + mCsvChunkBytes - 1) / mCsvChunkBytes);
+	std::vector<const char*> boundaries(numChunks + 1, end);
+	boundaries[0] = begin;
+	for (size_t i = 1; i < numChunks; ++i)
+	{
+		const char* boundary = std::max(begin + (end - begin) * i / numChunks, boundaries[i - 1]);
+		const char* lineEnd = FindLineEnd(boundary, end);
+		boundaries[i] = lineEnd < end ? lineEnd + 1 : end;
+	}
+
+	// Parse chunks in parallel into separate buffers
+	std::vector<CompositeChunk> chunks(numChunks);
+	auto parseChunks = [&](size_t first, size_t last, size_t) {
+		for (size_t i = first; i < last; ++i)
 		{
-			// Trim whitespace
-			cell.erase(cell.find_last_not_of(" \n\r\t") + 1);
-			cells.push_back(cell);
+			ParseCompositeRows(boundaries[i], boundaries[i + 1], columnSlots, numVariables, extents, chunks[i]);
 		}
+	};
+	if (numChunks == 1)
+	{
+		parseChunks(0, 1, 0);
+	}
+	else
+	{
+		// No more threads than chunks
+		size_t poolSize = numThreads == 0 ? std::thread::hardware_concurrency() : numThreads;
+		ThreadPool pool(std::min(poolSize, numChunks));
+		pool.ParallelFor(numChunks, 1, parseChunks);
+	}
+
+	// Concatenate in file order, so the composite order does not depend on the number of threads
+	size_t numComposite = 0;
+	size_t invalidRows = 0;
+	size_t irrelevantRows = 0;
+	for (const auto& chunk : chunks)
+	{
+		numComposite += chunk.X.size();
+		invalidRows += chunk.InvalidRows;
+		irrelevantRows += chunk.IrrelevantRows;
+	}
 
-		if (cells.size() < columnIndices.size())
+	X.reserve(numComposite);
+	Y.reserve(numComposite);
+	Z.reserve(numComposite);
+	Values.assign(numVariables, {});
+	for (auto& values : Values)
+	{
+		values.reserve(numComposite);
+	}
+	for (auto& chunk : chunks)
+	{
+		X.insert(X.end(), chunk.X.begin(), chunk.X.end());
+		Y.insert(Y.end(), chunk.Y.begin(), chunk.Y.end());
+		Z.insert(Z.end(), chunk.Z.begin(), chunk.Z.end());
+		for (size_t v = 0; v < numVariables; ++v)
 		{
-			++invalidRows;
-			continue;
+			Values[v].insert(Values[v].end(), chunk.Values[v].begin(), chunk.Values[v].end());
 		}
+		chunk = CompositeChunk();
+	}
 
-		// Extract values based on column indices
-		try
-		{
-			x = std::stod(cells[xCol]);
-			y = std::stod(cells[yCol]);
-			z = std::stod(cells[zCol]);
-			grade = std::stod(cells[gradeCol]);
+	// Summary output
+	std::cout << "Number of composites imported: " << numComposite << std::endl;
+	std::cout << "Number of rows skipped due to invalid data: " << invalidRows << std::endl;
+	std::cout << "Number of rows skipped due to irrelevant data beyond interpolation extents: " << irrelevantRows << std::endl;
+}
+
+void Composites::ParseCompositeRows(const char* begin, const char* end, const std::vector<int>& columnSlots, size_t numVariables,
+	const CoordinateExtents& extents, CompositeChunk& chunk)
+{
+	size_t lastColumn = columnSlots.size() - 1;
+	chunk.Values.assign(numVariables, {});
+	std::vector<double> row(3 + numVariables);
 
-			// Assume grade < 0 is invalid; could be user input in future
-			if (grade < 0)
+	const char* position = begin;
+	while (position < end)
+	{
+		const char* lineEnd = FindLineEnd(position, end);
+		const char* cell = position;
+		position = lineEnd < end ? lineEnd + 1 : end;
+
+		// Tokenise the line in place, parsing only the required columns
+		bool validValues = true;
+		size_t column = 0;
+		while (column <= lastColumn)
+		{
+			const char* cellEnd = std::find(cell, lineEnd, ',');
+			int slot = columnSlots[column];
+			if (slot >= 0 && !ParseValue(cell, cellEnd, row[slot]))
 			{
-				++invalidRows;
-				continue;
+				validValues = false;
+				break;
 			}
-			// Check whether composite is relevant
-			if (!IsRelevantComposite(x, y, z, grade, extents))
+			++column;
+			if (cellEnd == lineEnd)
 			{
-				++irrelevantRows;
-				continue;
+				break;
 			}
+			cell = cellEnd + 1;
+		}
 
-			// Valid, relevant composite; add to composite list
-			X.emplace_back(x);
-			Y.emplace_back(y);
-			Z.emplace_back(z);
-			Grade.emplace_back(grade);
+		// Rows with too few columns are invalid
+		if (!validValues || column <= lastColumn)
+		{
+			++chunk.InvalidRows;
+			continue;
 		}
-		catch (const std::invalid_argument& e)
+
+		// Assume grade < 0 is invalid; could be user input in future
+		for (size_t v = 0; v < numVariables; ++v)
 		{
-			++invalidRows;
+			validValues = validValues && row[3 + v] >= 0;
+		}
+
+		if (!validValues)
+		{
+			++chunk.InvalidRows;
 			continue;
 		}
-		catch (const std::out_of_range& e)
+
+		double x = row[0];
+		double y = row[1];
+		double z = row[2];
+
+		// Check whether composite is relevant
+		if (!IsRelevantComposite(x, y, z, extents))
 		{
-			++invalidRows;
+			++chunk.IrrelevantRows;
 			continue;
 		}
+
+		// Valid, relevant composite; add to the chunk's composite list
+		chunk.X.emplace_back(x);
+		chunk.Y.emplace_back(y);
+		chunk.Z.emplace_back(z);
+		for (size_t v = 0; v < numVariables; ++v)
+		{
+			chunk.Values[v].emplace_back(row[3 + v]);
+		}
 	}
+}
 
-	size_t numComposite = X.size();
+const char* Composites::FindLineEnd(const char* begin, const char* end)
+{
+	const void* lineEnd = std::memchr(begin, '\n', end - begin);
+	return lineEnd != nullptr ? static_cast<const char*>(lineEnd) : end;
+}
 
-	// Summary output
-	std::cout << "Number of composites imported: " << numComposite << std::endl;
-	std::cout << "Number of rows skipped due to invalid data: " << invalidRows << std::endl;
-	std::cout << "Number of rows skipped due to irrelevant data beyond interpolation extents: " << irrelevantRows << std::endl;
+bool Composites::ParseValue(const char* begin, const char* end, double& value)
+{
+	// Skip leading whitespace and an optional plus sign, as std::stod does
+	while (begin < end && (*begin == ' ' || *begin == '\t'))
+	{
+		++begin;
+	}
+	if (begin < end && *begin == '+')
+	{
+		++begin;
+		if (begin < end && *begin == '-')
+		{
+			return false;
+		}
+	}
+
+	// As with std::stod, trailing characters after a valid number are ignored
+	auto result = std::from_chars(begin, end, value);
+	return result.ec == std::errc() && result.ptr != begin;
 }
 
-bool Composites::IsRelevantComposite(double x, double y, double z, double grade, const CoordinateExtents& extents)
+bool Composites::IsRelevantComposite(double x, double y, double z, const CoordinateExtents& extents)
 {
 	// Don't import composite if beyond relevant interpolation limits
 	if (x < extents.MinX || x > extents.MaxX)
@@ -223,26 +755,89 @@ bool Composites::IsRelevantComposite(double x, double y, double z, double grade,
 	return true;
 }
 
+std::string Composites::ToLower(std::string string)
+{
+	std::transform(string.begin(), string.end(), string.begin(), tolower);
+	return string;
+}
+
 void Composites::FinishInitialization()
 {
 	size_t numComposite = X.size();
 
 	// Final checks
-	if (Y.size() != numComposite || Z.size() != numComposite || Grade.size() != numComposite)
+	if (Values.empty() || Values.size() != mVariableNames.size())
 	{
-		LogAndThrow<std::invalid_argument>("X,Y,Z,Grade vectors must be the same size.");
+		LogAndThrow<std::invalid_argument>("One value vector and name is required per variable.");
+	}
+	if (Y.size() != numComposite || Z.size() != numComposite)
+	{
+		LogAndThrow<std::invalid_argument>("X,Y,Z and value vectors must be the same size.");
+	}
+	for (const auto& values : Values)
+	{
+		if (values.size() != numComposite)
+		{
+			LogAndThrow<std::invalid_argument>("X,Y,Z and value vectors must be the same size.");
+		}
 	}
 	if (numComposite < 1)
 	{
 		LogAndThrow<std::invalid_argument>("At least one valid composite is required.");
 	}
 
-	// Build KdTree
-	BuildKdTree();
+	// Build KdTree, unless it was loaded with the composites
+	if (mSearchX == nullptr)
+	{
+		InitializeSearchCoordinates();
+	}
+	if (mKdTree == nullptr)
+	{
+		BuildKdTree();
+	}
+}
+
+void Composites::InitializeSearchCoordinates()
+{
+	// Spherical searches index the composite coordinates directly
+	if (mSearchAnisotropy.IsIsotropic())
+	{
+		mSearchX = X.data();
+		mSearchY = Y.data();
+		mSearchZ = Z.data();
+		return;
+	}
+
+	size_t numComposite = X.size();
+	mEllipsoidX.resize(numComposite);
+	mEllipsoidY.resize(numComposite);
+	mEllipsoidZ.resize(numComposite);
+	auto transform = [this](size_t begin, size_t end, size_t) {
+		for (size_t i = begin; i < end; ++i)
+		{
+			mSearchAnisotropy.Transform(X[i], Y[i], Z[i], mEllipsoidX[i], mEllipsoidY[i], mEllipsoidZ[i]);
+		}
+	};
+	if (numComposite <= mTransformChunkSize)
+	{
+		transform(0, numComposite, 0);
+	}
+	else
+	{
+		ThreadPool pool(mNumThreads);
+		pool.ParallelFor(numComposite, mTransformChunkSize, transform);
+	}
+
+	mSearchX = mEllipsoidX.data();
+	mSearchY = mEllipsoidY.data();
+	mSearchZ = mEllipsoidZ.data();
 }
 
 void Composites::BuildKdTree()
 {
-	mKdTree = new KDTree(3, *this);
+	// Construct without building, so the index is built once. Subtrees are built concurrently by up to
+	// mNumThreads threads; nanoflann uses the hardware concurrency for 0.
+	mKdTree = new KDTree(3, *this, nanoflann::KDTreeSingleIndexAdaptorParams(mKdTreeLeafSize,
+		nanoflann::KDTreeSingleIndexAdaptorFlags::SkipInitialBuildIndex, static_cast<unsigned int>(mNumThreads)));
 	mKdTree->buildIndex();
 }
\ No newline at end of file
@@ -7,10 +7,21 @@
 #include <string>
 #include <unordered_map>
 #include <limits>
+#include <cmath>
+#include <cstring>
+#include <charconv>
 #include <iomanip>
+#include <memory>
+#include <optional>
+#include <filesystem>
+#include <bit>
+#include <random>
 
 #include "include/nanoflann.hpp"
 #include "Blocks.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+#include "Anisotropy.hpp"
 #include "CoordinateExtents.hpp"
 
 /**
@@ -22,8 +33,23 @@ struct NearestCompositesResult
 	std::vector<double> Distances;
 };
 
+/**
+ * @brief Candidate composites gathered once for a group of nearby search points, e.g. a tile of blocks.
+ */
+struct CompositeCandidates
+{
+	std::vector<nanoflann::ResultItem<uint32_t, double>> Matches; // Radius search matches (index, squared distance)
+	std::vector<size_t> Indices; // Candidate composite indices
+	std::vector<double> X, Y, Z; // Candidate composite coordinates in search space, gathered for cache friendly scans
+};
+
 /**
  * @brief Class containing composite / sample information.
+ *
+ * Searches use an ellipsoid, set by a search anisotropy transform at construction (spherical by default). The
+ * kd-tree is built over the transformed composite coordinates, in which the ellipsoid is a sphere whose radius is
+ * its major range, so every search is a single bounded nearest neighbour query. Search distances are measured in
+ * this space, i.e. in major range units.
  */
 class Composites
 {
@@ -32,9 +58,21 @@ public:
 	 * @brief Reads in composites from csv file, filtering based on block extents and search radius.
 	 * 
 	 * First row in csv must contain column headers.
-	 * Required columns: 'X', 'Y', 'Z', 'Grade'.
+	 * Required columns: 'X', 'Y', 'Z', and one column per variable name (default 'Grade'); not case sensitive.
+	 * Large files are parsed, and the kd-tree is built, in parallel by numThreads threads (0 uses the system
+	 * hardware concurrency); the composite order always matches the file order.
+	 *
+	 * kdTreeLeafSize sets the maximum number of composites per kd-tree leaf.
+	 *
+	 * If useCache is true, the filtered composites are saved to a binary sidecar file next to the CSV, and
+	 * reloaded from it instead of parsing the CSV while the CSV size and modification time, the block extents,
+	 * search radius, variable names, kd-tree leaf size and search anisotropy are unchanged.
+	 *
+	 * maxSearchRadius should be the longest axis of the search ellipsoid, in model coordinates.
 	 */
-	Composites(const std::string& csvFilePath, const CoordinateExtents& blockExtents, double maxSearchRadius);
+	Composites(const std::string& csvFilePath, const CoordinateExtents& blockExtents, double maxSearchRadius,
+		const std::vector<std::string>& variableNames = { "Grade" }, size_t numThreads = 0, bool useCache = false,
+		size_t kdTreeLeafSize = mDefaultKdTreeLeafSize, const Anisotropy& searchAnisotropy = Anisotropy());
 
 	/**
 	 * @brief Initializes composites by copying input vectors of x,y,z coordinates, and grades
@@ -43,11 +81,37 @@ public:
 	 */
 	Composites(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, const std::vector<double>& grades);
 
+	/**
+	 * @brief Initializes composites by copying input vectors of x,y,z coordinates, and one vector of values per variable
+	 *
+	 * NOTE: Not memory efficient; recommended to use csv based import
+	 */
+	Composites(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z,
+		const std::vector<std::vector<double>>& values, const std::vector<std::string>& variableNames,
+		const Anisotropy& searchAnisotropy = Anisotropy());
+
 	/**
 	 * @brief Dispose of Kd Tree.
 	 */
 	~Composites();
 
+	/**
+	 * @brief Loads composites saved with SaveBinary, with a spherical search; throws std::runtime_error if the file
+	 * is not a valid composite file.
+	 */
+	static std::unique_ptr<Composites> LoadBinary(const std::string& filePath);
+
+	/**
+	 * @brief Saves composites and their kd-tree index to a binary columnar file.
+	 *
+	 * The file holds a small header, the variable names, then the X, Y, Z and value columns as raw little-endian
+	 * doubles, so loading is a memory mapping and copy with no parsing. The serialized kd-tree index follows the
+	 * columns, with a key over the coordinates and index bytes; on load, the index is reused if the key matches,
+	 * so processes sharing one file skip the kd-tree build. The file is written under a temporary name and renamed
+	 * into place, so it can be replaced while other processes read it.
+	 */
+	void SaveBinary(const std::string& filePath) const;
+
 	/**
 	 * @brief Get X value at composite index i
 	 */
@@ -64,9 +128,29 @@ public:
 	double GetZ(size_t i) const { return Z[i]; }
 
 	/**
-	 * @brief Get grade value at composite index i
+	 * @brief Get grade value of the first variable at composite index i
+	 */
+	double GetGrade(size_t i) const { return Values[0][i]; }
+
+	/**
+	 * @brief Get value of variable v at composite index i
+	 */
+	double GetValue(size_t i, size_t v) const { return Values[v][i]; }
+
+	/**
+	 * @brief Get all values of variable v, indexed by composite
+	 */
+	const std::vector<double>& GetValues(size_t v) const { return Values[v]; }
+
+	/**
+	 * @brief Get number of variables (value columns)
+	 */
+	size_t GetNumVariables() const { return Values.size(); }
+
+	/**
+	 * @brief Get variable (value column) names
 	 */
-	double GetGrade(size_t i) const { return Grade[i]; }
+	const std::vector<std::string>& GetVariableNames() const { return mVariableNames; }
 
 	/**
 	 * @brief Get number of composites
@@ -74,15 +158,68 @@ public:
 	size_t GetSize() const { return X.size(); }
 
 	/**
-	 * @brief Finds the nearest n composites to the given coordinates, constrained by a maximum spherical search distance.
+	 * @brief Finds the nearest n composites to the given coordinates, constrained by a maximum search distance.
 	 *
 	 * @param x,y,z Coordinates of point from which to search
 	 * @param n Number of composites
-	 * @maxDist Maximum search radius from the search point
+	 * @maxDist Maximum search distance from the search point; the major range of the search ellipsoid
 	 * @return Nearest composite result, comprising vectors of composite indices in order of increasing distance, and corresponding distances.
 	 */
 	NearestCompositesResult FindNearestComposites(double x, double y, double z, int n, double maxDist) const;
 
+	/**
+	 * @brief Finds the nearest n composites to the given coordinates, writing into a caller owned result.
+	 *
+	 * Reuses the capacity of the result vectors, so no heap allocations occur once they hold n elements.
+	 *
+	 * @param x,y,z Coordinates of point from which to search
+	 * @param n Number of composites
+	 * @maxDist Maximum search radius from the search point
+	 * @param result Nearest composite result; previous contents are overwritten.
+	 */
+	void FindNearestComposites(double x, double y, double z, int n, double maxDist, NearestCompositesResult& result) const;
+
+	/**
+	 * @brief Finds the nearest n composites to composite i, excluding composite i itself, for leave-one-out cross-validation.
+	 *
+	 * The kd-tree search skips composite i, so up to n other composites are found in a single search.
+	 *
+	 * @param i Index of the composite from which to search
+	 * @param n Number of composites
+	 * @maxDist Maximum search radius from composite i
+	 * @param result Nearest composite result; previous contents are overwritten.
+	 */
+	void FindNeighbouringComposites(size_t i, int n, double maxDist, NearestCompositesResult& result) const;
+
+	/**
+	 * @brief Gathers all composites within a search distance of the given coordinates as candidates for later searches.
+	 *
+	 * @param x,y,z Coordinates of point from which to search
+	 * @param radius Search distance; should cover the search distance of every point that will use the candidates
+	 * @param candidates Candidate composites; previous contents are overwritten.
+	 */
+	void FindCandidateComposites(double x, double y, double z, double radius, CompositeCandidates& candidates) const;
+
+	/**
+	 * @brief Finds the nearest n composites to the given coordinates from a list of candidates, constrained by a maximum
+	 * search distance.
+	 *
+	 * Equivalent to FindNearestComposites provided every composite within maxDist of the point is a candidate.
+	 *
+	 * @param x,y,z Coordinates of point from which to search
+	 * @param n Number of composites
+	 * @maxDist Maximum search radius from the search point
+	 * @param candidates Candidate composites from FindCandidateComposites
+	 * @param result Nearest composite result; previous contents are overwritten.
+	 */
+	void FindNearestCandidates(double x, double y, double z, int n, double maxDist,
+		const CompositeCandidates& candidates, NearestCompositesResult& result) const;
+
+	/**
+	 * @brief Returns the search distance of the offset (dx, dy, dz) in model coordinates.
+	 */
+	double GetSearchDistance(double dx, double dy, double dz) const;
+
 	/**
 	 * @brief Required methods below for nanoflann.
 	 */
@@ -97,40 +234,264 @@ public:
 
 private:
 	std::vector<double> X, Y, Z; // Composite/sample center locations; should not be modified after class initialization
-	std::vector<double> Grade; // Composite grades; should not be modified after class initialization
+	std::vector<std::vector<double>> Values; // Composite values per variable; should not be modified after class initialization
+	std::vector<std::string> mVariableNames; // Variable name of each value column
+
+	Anisotropy mSearchAnisotropy; // Transform of the search ellipsoid into a sphere
+	std::vector<double> mEllipsoidX, mEllipsoidY, mEllipsoidZ; // Transformed composite coordinates; empty for spherical searches
+	const double* mSearchX = nullptr; // Coordinates indexed by the kd-tree; X,Y,Z or the transformed coordinates
+	const double* mSearchY = nullptr;
+	const double* mSearchZ = nullptr;
+
+	// Number of composites per chunk when transforming coordinates for an ellipsoid search
+	static constexpr size_t mTransformChunkSize = 1 << 16;
+
+	static constexpr size_t mDefaultKdTreeLeafSize = 10;
 
 	// Create a KD-tree of composite data
 	using KDTree = nanoflann::KDTreeSingleIndexAdaptor<nanoflann::L2_Simple_Adaptor<double, Composites>, Composites, 3>;
-	KDTree* mKdTree;
+	KDTree* mKdTree = nullptr;
+	size_t mKdTreeLeafSize = mDefaultKdTreeLeafSize; // Maximum number of composites per kd-tree leaf
+	size_t mNumThreads = 0; // Number of threads for the kd-tree build; 0 uses the system hardware concurrency
+
+	uint64_t mSourceKey = 0; // Key of the CSV file and import settings the composites were read with; 0 if unknown
+
+	/**
+	 * @brief Header of the binary composite file format.
+	 */
+	struct BinaryHeader
+	{
+		char Magic[8];
+		uint32_t Version;
+		uint32_t NumVariables;
+		uint64_t NumComposites;
+		uint64_t SourceKey;
+		uint64_t NamesBytes; // Size of the variable names block, each name null terminated, padded to 8 bytes
+		uint64_t IndexBytes; // Size of the serialized kd-tree index after the columns; 0 if not stored
+		uint64_t IndexKey; // Key of the coordinates and index bytes, from ComputeIndexKey
+	};
+
+	static constexpr char mBinaryMagic[8] = { 'K', 'R', 'G', 'C', 'O', 'M', 'P', '\0' };
+	static constexpr uint32_t mBinaryVersion = 2;
+
+	/**
+	 * @brief Read-only stream buffer over memory, for loading the kd-tree index from a mapped file without copying.
+	 */
+	struct MemoryStreamBuffer : std::streambuf
+	{
+		MemoryStreamBuffer(const char* begin, const char* end)
+		{
+			char* data = const_cast<char*>(begin);
+			setg(data, data, data + (end - begin));
+		}
+	};
+
+	/**
+	 * @brief Write-only stream buffer that forwards to another buffer and hashes the bytes as HashBytes would, for
+	 * writing the kd-tree index to a file and computing its key without holding it in memory.
+	 *
+	 * The buffer is hashed whenever it fills, always a whole number of 8 byte words, so the key matches hashing all
+	 * the bytes at once as long as the stream is flushed only at the end.
+	 */
+	struct HashingStreamBuffer : std::streambuf
+	{
+		uint64_t Key; // Hash of the bytes written, starting from the initial key
+		uint64_t NumBytes = 0; // Number of bytes written
+
+		HashingStreamBuffer(std::streambuf* target, uint64_t key) : Key(key), mTarget(target)
+		{
+			setp(mBuffer, mBuffer + sizeof(mBuffer));
+		}
+
+	protected:
+		int_type overflow(int_type c) override
+		{
+			if (!Flush())
+			{
+				return traits_type::eof();
+			}
+			if (!traits_type::eq_int_type(c, traits_type::eof()))
+			{
+				*pptr() = traits_type::to_char_type(c);
+				pbump(1);
+			}
+			return traits_type::not_eof(c);
+		}
+
+		int sync() override { return Flush() ? 0 : -1; }
 
-	// List of required columns in the csv; not case sensitive
+	private:
+		std::streambuf* mTarget;
+		char mBuffer[1 << 16];
+
+		bool Flush()
+		{
+			std::streamsize size = pptr() - pbase();
+			HashBytes(Key, pbase(), static_cast<size_t>(size));
+			NumBytes += size;
+			bool written = mTarget->sputn(pbase(), size) == size;
+			setp(mBuffer, mBuffer + sizeof(mBuffer));
+			return written;
+		}
+	};
+
+	// Extension appended to the CSV file path for the binary cache
+	static constexpr const char* mCacheExtension = ".cache";
+
+	// Size in bytes of the CSV chunks parsed in parallel
+	static constexpr size_t mCsvChunkBytes = 4 << 20;
+
+	/**
+	 * @brief Composites and row counts parsed from one chunk of a CSV file.
+	 */
+	struct CompositeChunk
+	{
+		std::vector<double> X, Y, Z;
+		std::vector<std::vector<double>> Values;
+		size_t InvalidRows = 0;
+		size_t IrrelevantRows = 0;
+	};
+
+	// List of required coordinate columns in the csv; not case sensitive
 	const std::string mXColName = "x";
 	const std::string mYColName = "y";
 	const std::string mZColName = "z";
-	const std::string mGradeColName = "grade";
-	const std::vector<std::string> mRequiredColumns = {mXColName, mYColName, mZColName, mGradeColName};
 
 	/**
 	 * @brief Read in composite header and data from CSV, with validation.
 	 * 
-	 * Required columns defined in mRequiredCSVColumns.
+	 * Required columns are the coordinate columns plus one column per variable in mVariableNames.
 	 * Function excludes data beyond the block extents plus search radius
 	 * 
 	 * @param filePath path of the CSV file
 	 * @param blockExtents X,Y,Z coordinate extents of the blocks to be krigged
 	 * @param maxSearchRadius maximum search radius for the krigging
+	 * @param numThreads number of threads used to parse the data; 0 uses the system hardware concurrency
+	 */
+	void ReadCompositesFromCSV(const std::string& filePath, const CoordinateExtents& blockExtents, double maxSearchRadius,
+		size_t numThreads);
+
+	/**
+	 * @brief Private constructor for LoadBinary; composites are read, then initialized.
+	 */
+	Composites() = default;
+
+	/**
+	 * @brief Read in composites from a binary file saved with SaveBinary.
+	 *
+	 * @param expectedSourceKey If set, the file must have this source key and the variable names in mVariableNames;
+	 * otherwise the variable names are read from the file.
+	 * @return False if the file is invalid or does not match the expected key and variable names.
+	 */
+	bool ReadCompositesFromBinary(const std::string& filePath, std::optional<uint64_t> expectedSourceKey);
+
+	/**
+	 * @brief Loads the kd-tree from a serialized index in [begin, end), if its key matches the composites.
+	 *
+	 * @return False if the key does not match or the index is invalid; the kd-tree is then not created.
+	 */
+	bool LoadKdTree(const char* begin, const char* end, uint64_t indexKey);
+
+	/**
+	 * @brief Returns key over the search coordinates and the serialized index bytes in [begin, end).
+	 */
+	uint64_t ComputeIndexKey(const char* begin, const char* end) const;
+
+	/**
+	 * @brief Returns key over the search coordinates only; ComputeIndexKey continues it over the index bytes.
+	 */
+	uint64_t ComputeSearchCoordinatesKey() const;
+
+	/**
+	 * @brief Adds bytes to an FNV-1a style hash, eight bytes at a time.
 	 */
-	void ReadCompositesFromCSV(const std::string& filePath, const CoordinateExtents& blockExtents, double maxSearchRadius);
+	static void HashBytes(uint64_t& key, const void* data, size_t numBytes);
 
 	/**
-	 * @brief Read in composite data from CSV.
+	 * @brief Returns key identifying a CSV file's size and modification time together with the import and search
+	 * settings; 0 if the file does not exist.
 	 */
-	void ReadComposites(std::ifstream& file, std::unordered_map<std::string, size_t>& columnIndices, const CoordinateExtents& extents);
+	uint64_t ComputeSourceKey(const std::string& filePath, const CoordinateExtents& blockExtents, double maxSearchRadius) const;
+
+	/**
+	 * @brief Read in composite data rows from CSV text in [begin, end).
+	 *
+	 * The text is split into chunks of whole lines, which are parsed in parallel and then concatenated in order.
+	 */
+	void ReadComposites(const char* begin, const char* end, std::unordered_map<std::string, size_t>& columnIndices,
+		const CoordinateExtents& extents, size_t numThreads);
+
+	/**
+	 * @brief Parses the composite rows in [begin, end) into chunk, filtering invalid and irrelevant rows.
+	 *
+	 * Rows are tokenised in place and parsed with std::from_chars, without per-row allocations or exceptions.
+	 *
+	 * @param columnSlots Slot of each CSV column in the parsed row (x, y, z, then variables), or -1 if unused.
+	 */
+	static void ParseCompositeRows(const char* begin, const char* end, const std::vector<int>& columnSlots, size_t numVariables,
+		const CoordinateExtents& extents, CompositeChunk& chunk);
+
+	/**
+	 * @brief Returns pointer to the next newline character in [begin, end), or end if there is none.
+	 */
+	static const char* FindLineEnd(const char* begin, const char* end);
+
+	/**
+	 * @brief Parses a CSV cell as a double, allowing surrounding whitespace.
+	 *
+	 * @return False if the cell does not start with a valid number.
+	 */
+	static bool ParseValue(const char* begin, const char* end, double& value);
 
 	/**
 	 * @brief Checks if composite is relevant based on interpolation extents.
 	 */
-	static bool IsRelevantComposite(double x, double y, double z, double grade, const CoordinateExtents& extents);
+	static bool IsRelevantComposite(double x, double y, double z, const CoordinateExtents& extents);
+
+	/**
+	 * @brief Returns lower case copy of input string, for case insensitive column matching
+	 */
+	static std::string ToLower(std::string string);
+
+	/**
+	 * @brief Radius-bounded nearest neighbour result set that skips one composite.
+	 */
+	class ExcludingResultSet : public nanoflann::RKNNResultSet<double>
+	{
+	public:
+		ExcludingResultSet(size_t capacity, double maxDistSq, size_t excludedIndex)
+			: RKNNResultSet(capacity, maxDistSq), mExcludedIndex(excludedIndex)
+		{
+		}
+
+		bool addPoint(double dist, size_t index)
+		{
+			return index == mExcludedIndex || RKNNResultSet::addPoint(dist, index);
+		}
+
+	private:
+		size_t mExcludedIndex;
+	};
+
+	/**
+	 * @brief Returns the squared distance bound for a radius-bounded nearest neighbour result set.
+	 */
+	static double SearchBoundSq(double maxDistSq);
+
+	/**
+	 * @brief Keeps the first numFound results within maxDistSq, converting squared distances to distances.
+	 */
+	static void TrimNearestResult(size_t numFound, double maxDistSq, NearestCompositesResult& result);
+
+	/**
+	 * @brief Sets the coordinates indexed by the kd-tree, transforming the composites for an ellipsoid search.
+	 */
+	void InitializeSearchCoordinates();
+
+	/**
+	 * @brief Transforms a search point into the space indexed by the kd-tree.
+	 */
+	void TransformSearchPoint(double x, double y, double z, double point[3]) const;
 
 	/**
 	 * @brief Final data checks, then initialize Kd Tree. 
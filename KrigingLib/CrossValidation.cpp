@@ -0,0 +1,130 @@
+#include "CrossValidation.hpp"
+
+CrossValidationResults::CrossValidationResults(size_t numComposites, size_t numVariables)
+	: Estimates(numVariables, std::vector<double>(numComposites, std::numeric_limits<double>::quiet_NaN())),
+	KrigingVariances(numComposites, std::numeric_limits<double>::quiet_NaN()),
+	Statistics(numVariables)
+{
+}
+
+void CrossValidationResults::ComputeStatistics(const Composites& composites)
+{
+	for (size_t v = 0; v < Estimates.size(); ++v)
+	{
+		const auto& values = composites.GetValues(v);
+		const auto& estimates = Estimates[v];
+
+		// Sums over the estimated composites
+		size_t count = 0, countStandardized = 0;
+		double sumError = 0.0, sumAbsoluteError = 0.0, sumSquaredError = 0.0, sumStandardized = 0.0;
+		double sumTrue = 0.0, sumEstimate = 0.0, sumTrueSquared = 0.0, sumEstimateSquared = 0.0, sumProduct = 0.0;
+		for (size_t i = 0; i < estimates.size(); ++i)
+		{
+			if (std::isnan(estimates[i]))
+			{
+				continue;
+			}
+
+			double error = estimates[i] - values[i];
+			++count;
+			sumError += error;
+			sumAbsoluteError += std::abs(error);
+			sumSquaredError += error * error;
+			// A composite at the same location as another is estimated with zero variance, so it cannot be standardized
+			if (KrigingVariances[i] > 0.0)
+			{
+				++countStandardized;
+				sumStandardized += error * error / KrigingVariances[i];
+			}
+			sumTrue += values[i];
+			sumEstimate += estimates[i];
+			sumTrueSquared += values[i] * values[i];
+			sumEstimateSquared += estimates[i] * estimates[i];
+			sumProduct += values[i] * estimates[i];
+		}
+
+		CrossValidationStatistics& statistics = Statistics[v];
+		statistics = CrossValidationStatistics();
+		statistics.NumEstimated = count;
+		if (count == 0)
+		{
+			continue;
+		}
+
+		double n = static_cast<double>(count);
+		statistics.MeanError = sumError / n;
+		statistics.MeanAbsoluteError = sumAbsoluteError / n;
+		statistics.RootMeanSquaredError = sqrt(sumSquaredError / n);
+		if (countStandardized > 0)
+		{
+			statistics.MeanSquaredStandardizedError = sumStandardized / countStandardized;
+		}
+
+		double covariance = sumProduct / n - (sumTrue / n) * (sumEstimate / n);
+		double varianceTrue = sumTrueSquared / n - (sumTrue / n) * (sumTrue / n);
+		double varianceEstimate = sumEstimateSquared / n - (sumEstimate / n) * (sumEstimate / n);
+		statistics.Correlation = covariance / sqrt(varianceTrue * varianceEstimate);
+	}
+}
+
+void CrossValidationResults::PrintStatistics(const std::vector<std::string>& variableNames) const
+{
+	for (size_t v = 0; v < Statistics.size(); ++v)
+	{
+		const auto& statistics = Statistics[v];
+		std::cout << variableNames[v] << ": " << statistics.NumEstimated << " of " << Estimates[v].size() << " composites estimated"
+			<< ", mean error " << statistics.MeanError
+			<< ", mean absolute error " << statistics.MeanAbsoluteError
+			<< ", RMSE " << statistics.RootMeanSquaredError
+			<< ", correlation " << statistics.Correlation
+			<< ", mean squared standardized error " << statistics.MeanSquaredStandardizedError << std::endl;
+	}
+}
+
+void CrossValidationResults::WriteToCSV(const std::string& filePath, const Composites& composites) const
+{
+	std::cout << "Writing cross-validation results to file..." << std::endl;
+	std::ofstream file(filePath);
+	if (!file.is_open())
+	{
+		LogAndThrow<std::runtime_error>("Cannot write to file: " + filePath);
+	}
+
+	file << "X,Y,Z";
+	for (const auto& variableName : composites.GetVariableNames())
+	{
+		file << "," << variableName << "," << variableName << "Estimate";
+	}
+	file << ",KrigingVariance\n";
+
+	size_t numRows = composites.GetSize();
+	size_t numVariables = Estimates.size();
+	for (size_t i = 0; i < numRows; ++i)
+	{
+		file << composites.GetX(i) << "," << composites.GetY(i) << "," << composites.GetZ(i);
+		for (size_t v = 0; v < numVariables; ++v)
+		{
+			file << "," << composites.GetValues(v)[i] << ",";
+			if (std::isnan(Estimates[v][i]))
+			{
+				file << "NULL";
+			}
+			else
+			{
+				file << std::to_string(Estimates[v][i]);
+			}
+		}
+		if (std::isnan(KrigingVariances[i]))
+		{
+			file << ",NULL";
+		}
+		else
+		{
+			file << "," << KrigingVariances[i];
+		}
+		file << "\n";
+	}
+
+	file.close();
+	std::cout << "Finished writing. Results are in file: " << filePath << std::endl;
+}
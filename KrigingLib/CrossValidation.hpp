@@ -0,0 +1,61 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cmath>
+
+#include "Composites.hpp"
+#include "Helpers.hpp"
+
+/**
+ * @brief Error statistics of one variable's cross-validation estimates, over the composites that were estimated.
+ *
+ * Errors are estimate minus true value. Values other than NumEstimated are NaN if no composite was estimated.
+ * MeanSquaredStandardizedError covers only the composites with a positive kriging variance, so composites at the
+ * same location as another, estimated with zero variance, are excluded from it.
+ */
+struct CrossValidationStatistics
+{
+	size_t NumEstimated = 0; // Number of composites with enough neighbours to be estimated
+	double MeanError = std::numeric_limits<double>::quiet_NaN(); // Mean error; near zero if unbiased
+	double MeanAbsoluteError = std::numeric_limits<double>::quiet_NaN(); // Mean absolute error
+	double RootMeanSquaredError = std::numeric_limits<double>::quiet_NaN(); // Root mean squared error
+	double Correlation = std::numeric_limits<double>::quiet_NaN(); // Correlation between true and estimated values
+	double MeanSquaredStandardizedError = std::numeric_limits<double>::quiet_NaN(); // Mean of squared error over kriging variance; near one if the variances are realistic
+};
+
+/**
+ * @brief Leave-one-out cross-validation results: each composite re-estimated from its neighbours, excluding itself.
+ *
+ * Estimates are stored per variable, in composite order, with NaN marking composites that had too few neighbours.
+ */
+class CrossValidationResults
+{
+public:
+	std::vector<std::vector<double>> Estimates; // Estimates per variable; Estimates[v][i] is variable v at composite i
+	std::vector<double> KrigingVariances; // Kriging variance of each composite's estimate; shared by all variables
+	std::vector<CrossValidationStatistics> Statistics; // Error statistics per variable; filled by ComputeStatistics
+
+	/**
+	 * @brief Initializes numComposites estimates per variable as not estimated.
+	 */
+	CrossValidationResults(size_t numComposites, size_t numVariables);
+
+	/**
+	 * @brief Computes the error statistics of every variable against the composite values.
+	 */
+	void ComputeStatistics(const Composites& composites);
+
+	/**
+	 * @brief Writes the error statistics of every variable to the console.
+	 */
+	void PrintStatistics(const std::vector<std::string>& variableNames) const;
+
+	/**
+	 * @brief Writes each composite's location, true and estimated values, and kriging variance to CSV at the provided filepath
+	 */
+	void WriteToCSV(const std::string& filePath, const Composites& composites) const;
+};
@@ -0,0 +1,172 @@
+#include "DistanceKernel.hpp"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define DISTANCE_KERNEL_X64
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC compiles intrinsics for any instruction set without /arch
+#define TARGET_AVX
+#define TARGET_AVX512
+#elif defined(__clang__)
+// GCC and Clang compile intrinsics only in functions targeting their instruction set
+#define TARGET_AVX __attribute__((target("avx")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+// AVX-512F implies FMA, which GCC would otherwise fuse the intrinsics' multiplies and adds into
+#define TARGET_AVX __attribute__((target("avx"), optimize("fp-contract=off")))
+#define TARGET_AVX512 __attribute__((target("avx512f"), optimize("fp-contract=off")))
+#endif
+#endif
+
+const DistanceKernel::InstructionSet DistanceKernel::mInstructionSet = DistanceKernel::DetectInstructionSet();
+const DistanceKernel::ComputeFunction DistanceKernel::mCompute = DistanceKernel::GetKernel(DistanceKernel::mInstructionSet);
+
+void DistanceKernel::Compute(InstructionSet instructionSet, double x0, double y0, double z0, const double* xs, const double* ys,
+	const double* zs, size_t count, double* distances)
+{
+	GetKernel(instructionSet)(x0, y0, z0, xs, ys, zs, count, distances);
+}
+
+bool DistanceKernel::IsSupported(InstructionSet instructionSet)
+{
+	return instructionSet <= mInstructionSet;
+}
+
+const char* DistanceKernel::GetInstructionSet()
+{
+	switch (mInstructionSet)
+	{
+	case InstructionSet::Avx512:
+		return "AVX-512";
+	case InstructionSet::Avx:
+		return "AVX";
+	default:
+		return "Scalar";
+	}
+}
+
+DistanceKernel::InstructionSet DistanceKernel::DetectInstructionSet()
+{
+#if defined(DISTANCE_KERNEL_X64) && defined(_MSC_VER)
+	// AVX needs the CPU feature and the operating system saving the YMM registers (XCR0 bits 1-2); AVX-512
+	// also needs the opmask and ZMM registers saved (XCR0 bits 5-7)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx)
+	{
+		return InstructionSet::Scalar;
+	}
+	unsigned long long xcr0 = _xgetbv(0);
+	if ((xcr0 & 0x6) != 0x6)
+	{
+		return InstructionSet::Scalar;
+	}
+	if (maxLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		bool avx512f = (info[1] & (1 << 16)) != 0;
+		if (avx512f && (xcr0 & 0xE6) == 0xE6)
+		{
+			return InstructionSet::Avx512;
+		}
+	}
+	return InstructionSet::Avx;
+#elif defined(DISTANCE_KERNEL_X64)
+	// Checks both the CPU feature and operating system support
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+	{
+		return InstructionSet::Avx512;
+	}
+	if (__builtin_cpu_supports("avx"))
+	{
+		return InstructionSet::Avx;
+	}
+	return InstructionSet::Scalar;
+#else
+	return InstructionSet::Scalar;
+#endif
+}
+
+DistanceKernel::ComputeFunction DistanceKernel::GetKernel(InstructionSet instructionSet)
+{
+	switch (instructionSet)
+	{
+	case InstructionSet::Avx512:
+		return &ComputeAvx512;
+	case InstructionSet::Avx:
+		return &ComputeAvx;
+	default:
+		return &ComputeScalar;
+	}
+}
+
+void DistanceKernel::ComputeScalar(double x0, double y0, double z0, const double* xs, const double* ys, const double* zs,
+	size_t count, double* distances)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		double dx = xs[i] - x0;
+		double dy = ys[i] - y0;
+		double dz = zs[i] - z0;
+		distances[i] = sqrt(dx * dx + dy * dy + dz * dz);
+	}
+}
+
+#if defined(DISTANCE_KERNEL_X64)
+TARGET_AVX
+void DistanceKernel::ComputeAvx(double x0, double y0, double z0, const double* xs, const double* ys, const double* zs,
+	size_t count, double* distances)
+{
+	size_t i = 0;
+	const __m256d x0v = _mm256_set1_pd(x0);
+	const __m256d y0v = _mm256_set1_pd(y0);
+	const __m256d z0v = _mm256_set1_pd(z0);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + i), x0v);
+		__m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + i), y0v);
+		__m256d dz = _mm256_sub_pd(_mm256_loadu_pd(zs + i), z0v);
+		__m256d squared = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), _mm256_mul_pd(dz, dz));
+		_mm256_storeu_pd(distances + i, _mm256_sqrt_pd(squared));
+	}
+	ComputeScalar(x0, y0, z0, xs + i, ys + i, zs + i, count - i, distances + i);
+}
+
+TARGET_AVX512
+void DistanceKernel::ComputeAvx512(double x0, double y0, double z0, const double* xs, const double* ys, const double* zs,
+	size_t count, double* distances)
+{
+	size_t i = 0;
+	const __m512d x0v = _mm512_set1_pd(x0);
+	const __m512d y0v = _mm512_set1_pd(y0);
+	const __m512d z0v = _mm512_set1_pd(z0);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m512d dx = _mm512_sub_pd(_mm512_loadu_pd(xs + i), x0v);
+		__m512d dy = _mm512_sub_pd(_mm512_loadu_pd(ys + i), y0v);
+		__m512d dz = _mm512_sub_pd(_mm512_loadu_pd(zs + i), z0v);
+		__m512d squared = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)), _mm512_mul_pd(dz, dz));
+		_mm512_storeu_pd(distances + i, _mm512_sqrt_pd(squared));
+	}
+	// The remainder of fewer than 8 may still fill a 4-wide AVX register
+	ComputeAvx(x0, y0, z0, xs + i, ys + i, zs + i, count - i, distances + i);
+}
+#else
+void DistanceKernel::ComputeAvx(double x0, double y0, double z0, const double* xs, const double* ys, const double* zs,
+	size_t count, double* distances)
+{
+	ComputeScalar(x0, y0, z0, xs, ys, zs, count, distances);
+}
+
+void DistanceKernel::ComputeAvx512(double x0, double y0, double z0, const double* xs, const double* ys, const double* zs,
+	size_t count, double* distances)
+{
+	ComputeScalar(x0, y0, z0, xs, ys, zs, count, distances);
+}
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+/**
+ * @brief Vectorized Euclidean distances from one point to many, over structure of arrays coordinates.
+ *
+ * The widest kernel the CPU and operating system support is selected once, at startup, from CPUID: 8-wide
+ * AVX-512, 4-wide AVX or scalar. The vector kernels are compiled for their instruction sets regardless of the
+ * build's /arch or -m flags, so one binary uses AVX-512 or AVX where available and still runs on any x64 CPU.
+ * Every kernel sums the squared coordinate differences in x, y, z order without fused multiply-adds, so all
+ * give identical distances.
+ */
+class DistanceKernel
+{
+public:
+	enum class InstructionSet
+	{
+		Scalar = 0,
+		Avx = 1,
+		Avx512 = 2
+	};
+
+	/**
+	 * @brief Computes distances[i] = |p_i - p0| for i in [0, count), with the kernel selected for this CPU.
+	 */
+	static void Compute(double x0, double y0, double z0, const double* xs, const double* ys, const double* zs,
+		size_t count, double* distances)
+	{
+		mCompute(x0, y0, z0, xs, ys, zs, count, distances);
+	}
+
+	/**
+	 * @brief Computes distances with the kernel for the given instruction set, which must be supported.
+	 */
+	static void Compute(InstructionSet instructionSet, double x0, double y0, double z0, const double* xs, const double* ys,
+		const double* zs, size_t count, double* distances);
+
+	/**
+	 * @brief Returns true if this CPU and operating system support the instruction set.
+	 */
+	static bool IsSupported(InstructionSet instructionSet);
+
+	/**
+	 * @brief Get name of the instruction set of the kernel selected for this CPU
+	 */
+	static const char* GetInstructionSet();
+
+private:
+	using ComputeFunction = void (*)(double, double, double, const double*, const double*, const double*, size_t, double*);
+
+	static const InstructionSet mInstructionSet; // Widest supported instruction set; detected once at startup
+	static const ComputeFunction mCompute; // Kernel for mInstructionSet
+
+	static InstructionSet DetectInstructionSet();
+
+	static ComputeFunction GetKernel(InstructionSet instructionSet);
+
+	static void ComputeScalar(double x0, double y0, double z0, const double* xs, const double* ys, const double* zs,
+		size_t count, double* distances);
+
+	static void ComputeAvx(double x0, double y0, double z0, const double* xs, const double* ys, const double* zs,
+		size_t count, double* distances);
+
+	static void ComputeAvx512(double x0, double y0, double z0, const double* xs, const double* ys, const double* zs,
+		size_t count, double* distances);
+};
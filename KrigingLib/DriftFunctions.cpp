@@ -0,0 +1,99 @@
+#include "DriftFunctions.hpp"
+
+DriftFunctions::DriftFunctions(const IsotropicCoordinates& coordinates, size_t numComposites, KrigingParameters::DriftType drift,
+	const CoordinateExtents& region, bool precompute, ThreadPool* pool)
+	: mCoordinates(coordinates), mDrift(drift), mNumTerms(KrigingParameters::GetNumDriftTerms(drift))
+{
+	// Centre and half diagonal of the region in isotropic space; with anisotropy the longest diagonal may be any of four
+	coordinates.TransformPoint(0.5 * (region.MinX + region.MaxX), 0.5 * (region.MinY + region.MaxY), 0.5 * (region.MinZ + region.MaxZ),
+		mOriginX, mOriginY, mOriginZ);
+	double halfX = 0.5 * (region.MaxX - region.MinX);
+	double halfY = 0.5 * (region.MaxY - region.MinY);
+	double halfZ = 0.5 * (region.MaxZ - region.MinZ);
+	double scale = 0.0;
+	for (double signX : { -1.0, 1.0 })
+	{
+		for (double signY : { -1.0, 1.0 })
+		{
+			double tx, ty, tz;
+			coordinates.TransformPoint(signX * halfX, signY * halfY, halfZ, tx, ty, tz);
+			scale = std::max(scale, sqrt(tx * tx + ty * ty + tz * tz));
+		}
+	}
+	if (scale > 0.0)
+	{
+		mInverseScale = 1.0 / scale;
+	}
+
+	if (!precompute)
+	{
+		return;
+	}
+
+	mValues.resize(numComposites * mNumTerms);
+	auto evaluate = [this, &coordinates](size_t begin, size_t end, size_t) {
+		for (size_t i = begin; i < end; ++i)
+		{
+			double x, y, z;
+			coordinates.Get(i, x, y, z);
+			Evaluate(x, y, z, mValues.data() + i * mNumTerms);
+		}
+	};
+	if (pool != nullptr)
+	{
+		pool->ParallelFor(numComposites, mChunkSize, evaluate);
+	}
+	else
+	{
+		evaluate(0, numComposites, 0);
+	}
+	mIsPrecomputed = true;
+}
+
+void DriftFunctions::Evaluate(double x, double y, double z, double* terms) const
+{
+	double u = (x - mOriginX) * mInverseScale;
+	double v = (y - mOriginY) * mInverseScale;
+	double w = (z - mOriginZ) * mInverseScale;
+	terms[0] = 1.0;
+	terms[1] = u;
+	terms[2] = v;
+	terms[3] = w;
+	if (mDrift == KrigingParameters::DriftType::Quadratic)
+	{
+		terms[4] = u * u;
+		terms[5] = v * v;
+		terms[6] = w * w;
+		terms[7] = u * v;
+		terms[8] = u * w;
+		terms[9] = v * w;
+	}
+}
+
+void DriftFunctions::EvaluateBlock(double x0, double y0, double z0, const BlockDiscretization& discretization, double* terms) const
+{
+	size_t numPoints = discretization.GetNumPoints();
+	if (numPoints == 1)
+	{
+		Evaluate(x0, y0, z0, terms);
+		return;
+	}
+
+	// Quadratic terms are not linear, so the block average differs from the terms at the centroid
+	double pointTerms[MaxNumTerms];
+	std::fill_n(terms, mNumTerms, 0.0);
+	for (size_t p = 0; p < numPoints; ++p)
+	{
+		double dx, dy, dz;
+		discretization.GetOffset(p, dx, dy, dz);
+		Evaluate(x0 + dx, y0 + dy, z0 + dz, pointTerms);
+		for (size_t t = 0; t < mNumTerms; ++t)
+		{
+			terms[t] += pointTerms[t];
+		}
+	}
+	for (size_t t = 0; t < mNumTerms; ++t)
+	{
+		terms[t] /= numPoints;
+	}
+}
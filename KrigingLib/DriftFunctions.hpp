@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "CoordinateExtents.hpp"
+#include "KrigingParameters.hpp"
+#include "IsotropicCoordinates.hpp"
+#include "BlockDiscretization.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * @brief Polynomial drift terms of composites for universal kriging.
+ *
+ * Terms are evaluated in the isotropic space of the variogram. Linear and quadratic polynomials of a linearly
+ * transformed point span the same functions as those of the original point, so the estimates equal those with
+ * a drift in model coordinates. Coordinates are centred and scaled to about [-1, 1] over a region, so the drift
+ * terms have magnitudes similar to the covariances in the kriging system.
+ *
+ * With precompute set, the terms of all composites are evaluated once up front, so kriging systems only copy them.
+ * Otherwise they are evaluated on access, which suits estimating a few points.
+ */
+class DriftFunctions
+{
+public:
+	// Number of terms of the quadratic drift, the largest supported
+	static constexpr int MaxNumTerms = 10;
+
+	/**
+	 * @param coordinates Composite coordinates in the variogram's isotropic space.
+	 * @param region Region of model space the drift is scaled over, e.g. the block model extents.
+	 * @param pool Thread pool for the precomputation; may be nullptr to evaluate on the calling thread.
+	 */
+	DriftFunctions(const IsotropicCoordinates& coordinates, size_t numComposites, KrigingParameters::DriftType drift,
+		const CoordinateExtents& region, bool precompute, ThreadPool* pool = nullptr);
+
+	/**
+	 * @brief Get number of drift terms, including the constant term
+	 */
+	size_t GetNumTerms() const { return mNumTerms; }
+
+	/**
+	 * @brief Gets the drift terms of composite i.
+	 */
+	void Get(size_t i, double* terms) const
+	{
+		if (mIsPrecomputed)
+		{
+			const double* values = mValues.data() + i * mNumTerms;
+			for (size_t t = 0; t < mNumTerms; ++t)
+			{
+				terms[t] = values[t];
+			}
+		}
+		else
+		{
+			double x, y, z;
+			mCoordinates.Get(i, x, y, z);
+			Evaluate(x, y, z, terms);
+		}
+	}
+
+	/**
+	 * @brief Evaluates the drift terms at a point in isotropic space.
+	 */
+	void Evaluate(double x, double y, double z, double* terms) const;
+
+	/**
+	 * @brief Evaluates the average drift terms over the block centred on p0, a point in isotropic space.
+	 */
+	void EvaluateBlock(double x0, double y0, double z0, const BlockDiscretization& discretization, double* terms) const;
+
+private:
+	const IsotropicCoordinates& mCoordinates;
+	KrigingParameters::DriftType mDrift;
+	size_t mNumTerms;
+	double mOriginX = 0.0, mOriginY = 0.0, mOriginZ = 0.0; // Centre of the region in isotropic space
+	double mInverseScale = 1.0; // Inverse of the region's half diagonal in isotropic space
+	bool mIsPrecomputed = false;
+	std::vector<double> mValues; // Drift terms of each composite, mNumTerms per composite; only filled if precomputed
+
+	// Number of composites per chunk for the parallel precomputation
+	static constexpr size_t mChunkSize = 1 << 16;
+};
@@ -1,9 +1,12 @@
+#pragma once
+
 #include <string>
 #include <stdexcept>
 #include <iostream>
 
+// Never returns, so callers that end in LogAndThrow need no unreachable return
 template <typename ExceptionType>
-static void LogAndThrow(const std::string& errorMessage)
+[[noreturn]] static void LogAndThrow(const std::string& errorMessage)
 {
     std::cerr << "Error: " << errorMessage << std::endl;
 
@@ -0,0 +1,32 @@
+#include "IsotropicCoordinates.hpp"
+
+IsotropicCoordinates::IsotropicCoordinates(const Composites& composites, const Anisotropy& anisotropy, bool precompute,
+	ThreadPool* pool)
+	: mComposites(composites), mAnisotropy(anisotropy)
+{
+	if (!precompute || mAnisotropy.IsIsotropic())
+	{
+		return;
+	}
+
+	size_t numComposites = composites.GetSize();
+	mX.resize(numComposites);
+	mY.resize(numComposites);
+	mZ.resize(numComposites);
+
+	auto transform = [this, &composites](size_t begin, size_t end, size_t) {
+		for (size_t i = begin; i < end; ++i)
+		{
+			mAnisotropy.Transform(composites.GetX(i), composites.GetY(i), composites.GetZ(i), mX[i], mY[i], mZ[i]);
+		}
+	};
+	if (pool != nullptr)
+	{
+		pool->ParallelFor(numComposites, mChunkSize, transform);
+	}
+	else
+	{
+		transform(0, numComposites, 0);
+	}
+	mIsPrecomputed = true;
+}
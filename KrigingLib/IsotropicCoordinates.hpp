@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+
+#include "Anisotropy.hpp"
+#include "Composites.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * @brief Composite coordinates in the isotropic space of a variogram.
+ *
+ * With precompute set, all composites are transformed once up front, so kriging systems only evaluate plain
+ * Euclidean distances. Otherwise coordinates are transformed on access, which suits estimating a few points.
+ * Isotropic variograms use the composite coordinates directly.
+ */
+class IsotropicCoordinates
+{
+public:
+	/**
+	 * @param anisotropy Transform into the variogram's isotropic space, e.g. VariogramModel::GetAnisotropy.
+	 * @param pool Thread pool for the precomputation; may be nullptr to transform on the calling thread.
+	 */
+	IsotropicCoordinates(const Composites& composites, const Anisotropy& anisotropy, bool precompute,
+		ThreadPool* pool = nullptr);
+
+	/**
+	 * @brief Gets the isotropic coordinates of composite i.
+	 */
+	void Get(size_t i, double& x, double& y, double& z) const
+	{
+		if (mIsPrecomputed)
+		{
+			x = mX[i];
+			y = mY[i];
+			z = mZ[i];
+		}
+		else
+		{
+			TransformPoint(mComposites.GetX(i), mComposites.GetY(i), mComposites.GetZ(i), x, y, z);
+		}
+	}
+
+	/**
+	 * @brief Transforms a point, e.g. a block centroid, into isotropic space.
+	 */
+	void TransformPoint(double x, double y, double z, double& tx, double& ty, double& tz) const
+	{
+		if (mAnisotropy.IsIsotropic())
+		{
+			tx = x;
+			ty = y;
+			tz = z;
+		}
+		else
+		{
+			mAnisotropy.Transform(x, y, z, tx, ty, tz);
+		}
+	}
+
+private:
+	const Composites& mComposites;
+	Anisotropy mAnisotropy;
+	bool mIsPrecomputed = false;
+	std::vector<double> mX, mY, mZ; // Transformed composite coordinates; only filled if precomputed
+
+	// Number of composites per chunk for the parallel precomputation
+	static constexpr size_t mChunkSize = 1 << 16;
+};
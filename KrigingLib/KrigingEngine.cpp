@@ -2,67 +2,50 @@
 
 double KrigingEngine::Variogram(double h, const VariogramParameters& parameters)
 {
-	// lag distance normalized by the range
-	double ha = h / parameters.Range;
-	double contribution = parameters.Sill - parameters.Nugget;
-
-	switch (parameters.Structure)
-	{
-	case VariogramParameters::Spherical:
-		if (h > parameters.Range)
-		{
-			return parameters.Sill;
-		}
-		return parameters.Nugget + contribution * (1.5 * ha - 0.5 * ha * ha * ha);
-	case VariogramParameters::Exponential:
-		return parameters.Nugget + contribution * (1 - exp(-3 * ha));
-	case VariogramParameters::Gaussian:
-		return parameters.Nugget + contribution * (1 - exp(-3 * ha * ha));
-	default:
-		LogAndThrow<std::invalid_argument>("Unsupported variogram model");
-	}
-
-	//TODO: Add support for anisotropy and rotated variograms with rotation matrix
+	return VariogramModel(parameters).Variogram(h);
 }
 
 double KrigingEngine::Covariance(double h, const VariogramParameters& parameters)
 {
-	double gamma_h = Variogram(h, parameters);
-	return parameters.Sill - gamma_h;
+	return VariogramModel(parameters).Covariance(h);
 }
 
 double KrigingEngine::OrdinaryKrigingPoint(double x0, double y0, double z0,
 	const std::vector<double>& xs, const std::vector<double>& ys, const std::vector<double>& zs,
-	const std::vector<double>& values, const VariogramParameters& parameters)
+	const std::vector<double>& values, const VariogramParameters& parameters, KrigingParameters::SolverType solver)
 {
-	size_t n = values.size();
-
-	Eigen::MatrixXd C(n + 1, n + 1); // LHS Covariance matrix cij between sample locations i,j
-	Eigen::VectorXd D(n + 1); // RHS Covariance vector ci0 between sample locations i and estimation point 0
+	KrigingSystem<Eigen::Dynamic> system;
+	VariogramModel model(parameters);
+	BlockDiscretization point(model);
 
-	// Fill the kriging matrix with covariance values
-	for (size_t i = 0; i < n; ++i)
+	const Anisotropy& anisotropy = model.GetAnisotropy();
+	if (anisotropy.IsIsotropic())
 	{
-		for (size_t j = 0; j < n; ++j)
-		{
-			C(i, j) = Covariance(EuclideanDistance(xs[i], ys[i], zs[i], xs[j], ys[j], zs[j]), parameters);
-		}
-		// Lagrange multiplier
-		C(i, n) = 1.0;
-		C(n, i) = 1.0;
+		return OrdinaryKrigingPoint<Eigen::Dynamic>(x0, y0, z0, xs, ys, zs, values, model, point, solver, system);
 	}
-	// Bottom-right corner for Lagrange multiplier
-	C(n, n) = 0.0;
 
-	// Fill the right-hand side vector
+	// Transform the point and samples into the first structure's isotropic space
+	size_t n = xs.size();
+	std::vector<double> txs(n), tys(n), tzs(n);
 	for (size_t i = 0; i < n; ++i)
 	{
-		D(i) = Covariance(EuclideanDistance(xs[i], ys[i], zs[i], x0, y0, z0), parameters);
+		anisotropy.Transform(xs[i], ys[i], zs[i], txs[i], tys[i], tzs[i]);
 	}
-	D(n) = 1.0;
+	double tx0, ty0, tz0;
+	anisotropy.Transform(x0, y0, z0, tx0, ty0, tz0);
+	return OrdinaryKrigingPoint<Eigen::Dynamic>(tx0, ty0, tz0, txs, tys, tzs, values, model, point, solver, system);
+}
 
-	// Solve for the kriging weights
-	Eigen::VectorXd weights = C.colPivHouseholderQr().solve(D);
+template <int MaxN>
+double KrigingEngine::OrdinaryKrigingPoint(double x0, double y0, double z0,
+	const std::vector<double>& xs, const std::vector<double>& ys, const std::vector<double>& zs,
+	const std::vector<double>& values, const VariogramModel& model, const BlockDiscretization& discretization,
+	KrigingParameters::SolverType solver, KrigingSystem<MaxN>& system)
+{
+	size_t n = values.size();
+
+	OrdinaryKrigingWeights<MaxN>(x0, y0, z0, xs, ys, zs, model, discretization, solver, system);
+	const auto& weights = system.Weights;
 
 	// Compute the kriged value
 	double krigedValue = 0.0;
@@ -74,88 +57,852 @@ double KrigingEngine::OrdinaryKrigingPoint(double x0, double y0, double z0,
 	return krigedValue;
 }
 
-std::optional<double> KrigingEngine::KrigeOneBlock(double blockX, double blockY, double blockZ,
-	const KrigingParameters& parameters, const Composites& composites)
+template <int MaxN>
+void KrigingEngine::OrdinaryKrigingWeights(double x0, double y0, double z0,
+	const std::vector<double>& xs, const std::vector<double>& ys, const std::vector<double>& zs,
+	const VariogramModel& model, const BlockDiscretization& discretization, KrigingParameters::SolverType solver,
+	KrigingSystem<MaxN>& system)
 {
-	// Find nearest composites
-	auto nearestComposites = composites.FindNearestComposites(blockX, blockY, blockZ, parameters.MaxNumComposites, parameters.MaxRadius);
+	size_t n = xs.size();
+
+	system.Resize(n);
+	FillCovariances<MaxN>(x0, y0, z0, xs, ys, zs, model, discretization, system);
+	auto& C = system.C;
 
-	// Skip block if not enough composites
-	if (nearestComposites.Indices.size() < parameters.MinNumComposites)
+	// Lagrange multiplier row and column
+	for (size_t j = 0; j < n; ++j)
+	{
+		C(j, n) = 1.0;
+		C(n, j) = 1.0;
+	}
+	// Bottom-right corner for Lagrange multiplier
+	C(n, n) = 0.0;
+	system.D(n) = 1.0;
+
+	// Solve for the kriging weights
+	system.Solve(solver);
+}
+
+template <int MaxN>
+void KrigingEngine::SimpleKrigingWeights(double x0, double y0, double z0,
+	const std::vector<double>& xs, const std::vector<double>& ys, const std::vector<double>& zs,
+	const VariogramModel& model, const BlockDiscretization& discretization, KrigingParameters::SolverType solver,
+	KrigingSystem<MaxN>& system)
+{
+	system.Resize(xs.size(), KrigingParameters::KrigingType::Simple);
+	FillCovariances<MaxN>(x0, y0, z0, xs, ys, zs, model, discretization, system);
+
+	// Without the unbiasedness constraint the system is the covariance matrix alone
+	system.Solve(solver);
+}
+
+template <int MaxN>
+void KrigingEngine::UniversalKrigingWeights(double x0, double y0, double z0,
+	const std::vector<double>& xs, const std::vector<double>& ys, const std::vector<double>& zs,
+	const std::vector<size_t>& indices, const DriftFunctions& drift, const VariogramModel& model,
+	const BlockDiscretization& discretization, KrigingParameters::SolverType solver, KrigingSystem<MaxN>& system)
+{
+	static_assert(DriftFunctions::MaxNumTerms <= KrigingSystem<MaxN>::MaxNumConstraints);
+
+	size_t n = xs.size();
+	size_t p = drift.GetNumTerms();
+
+	system.Resize(n, KrigingParameters::KrigingType::Universal, p);
+	FillCovariances<MaxN>(x0, y0, z0, xs, ys, zs, model, discretization, system);
+	auto& C = system.C;
+
+	// Border the covariances with the precomputed drift terms of each sample
+	double terms[DriftFunctions::MaxNumTerms];
+	for (size_t i = 0; i < n; ++i)
+	{
+		drift.Get(indices[i], terms);
+		for (size_t t = 0; t < p; ++t)
+		{
+			C(i, n + t) = terms[t];
+			C(n + t, i) = terms[t];
+		}
+	}
+	C.bottomRightCorner(p, p).setZero();
+
+	// The weights must reproduce the drift averaged over the block
+	drift.EvaluateBlock(x0, y0, z0, discretization, system.D.data() + n);
+
+	system.Solve(solver);
+}
+
+template <int MaxN>
+void KrigingEngine::FillCovariances(double x0, double y0, double z0,
+	const std::vector<double>& xs, const std::vector<double>& ys, const std::vector<double>& zs,
+	const VariogramModel& model, const BlockDiscretization& discretization, KrigingSystem<MaxN>& system)
+{
+	size_t n = xs.size();
+	auto& C = system.C;
+
+	// Covariances depend on the lag direction only if nested structures have different anisotropies
+	bool distanceOnly = model.IsDistanceOnly();
+
+	// Fill the lower triangle of the kriging matrix with covariance values, one contiguous column at a time
+	for (size_t j = 0; j < n; ++j)
+	{
+		double* column = &C(j, j);
+		if (distanceOnly)
+		{
+			// Lag distances to samples j..n-1, converted to covariances in place
+			DistanceKernel::Compute(xs[j], ys[j], zs[j], xs.data() + j, ys.data() + j, zs.data() + j, n - j, column);
+			model.Covariances(column, n - j);
+		}
+		else
+		{
+			for (size_t i = j; i < n; ++i)
+			{
+				column[i - j] = model.Covariance(xs[j] - xs[i], ys[j] - ys[i], zs[j] - zs[i]);
+			}
+		}
+	}
+
+	// Mirror into the upper triangle
+	for (size_t j = 0; j < n; ++j)
+	{
+		for (size_t i = j + 1; i < n; ++i)
+		{
+			C(j, i) = C(i, j);
+		}
+	}
+
+	// Fill the right-hand side vector with sample-block covariances
+	discretization.BlockCovariances(x0, y0, z0, xs.data(), ys.data(), zs.data(), n, model, system.D.data(),
+		system.PointCovariances.data());
+}
+
+std::optional<std::vector<double>> KrigingEngine::KrigeOneBlock(double blockX, double blockY, double blockZ,
+	const KrigingParameters& parameters, const Composites& composites, KrigingDiagnostics* diagnostics)
+{
+	if (IsMissingGlobalMeans(parameters))
+	{
+		return KrigeOneBlock(blockX, blockY, blockZ, WithCompositeMeans(parameters, composites), composites, diagnostics);
+	}
+
+	KrigingWorkspace<Eigen::Dynamic> workspace(parameters.MaxNumComposites, GetNumEstimates(parameters, composites));
+
+	// Transform only the neighbourhood's coordinates for a single block
+	VariogramModel model(parameters.VariogramParameters, parameters.CovarianceTable, parameters.CovarianceTableResolution);
+	IsotropicCoordinates coordinates(composites, model.GetAnisotropy(), false);
+
+	// Only discretized blocks need the block size, so point kriging does not require the block model definition
+	const auto& counts = parameters.BlockDiscretization;
+	double blockSizeX = 0.0, blockSizeY = 0.0, blockSizeZ = 0.0;
+	if (counts.CountI * counts.CountJ * counts.CountK > 1)
+	{
+		const auto& blockInfo = parameters.BlockParameters;
+		const auto& extents = blockInfo.BlockCoordExtents;
+		blockSizeX = (extents.MaxX - extents.MinX) / blockInfo.BlockCountI;
+		blockSizeY = (extents.MaxY - extents.MinY) / blockInfo.BlockCountJ;
+		blockSizeZ = (extents.MaxZ - extents.MinZ) / blockInfo.BlockCountK;
+	}
+	BlockDiscretization discretization(parameters.BlockDiscretization, blockSizeX, blockSizeY, blockSizeZ, model);
+
+	// Drift terms are evaluated on access, scaled over the search neighbourhood of the block
+	std::optional<DriftFunctions> drift;
+	if (parameters.Type == KrigingParameters::KrigingType::Universal)
+	{
+		double range = parameters.GetMaxSearchRange();
+		CoordinateExtents region = { blockX - range, blockY - range, blockZ - range, blockX + range, blockY + range, blockZ + range };
+		drift.emplace(coordinates, composites.GetSize(), parameters.Drift, region, false);
+	}
+
+	bool estimated = KrigeOneBlock<Eigen::Dynamic>(blockX, blockY, blockZ, parameters, composites, coordinates, model, discretization,
+		drift ? &*drift : nullptr, workspace, diagnostics != nullptr);
+
+	if (diagnostics != nullptr)
+	{
+		*diagnostics = workspace.Diagnostics;
+	}
+	if (!estimated)
 	{
 		return std::nullopt;
 	}
+	return workspace.Estimates;
+}
+
+template <int MaxN>
+bool KrigingEngine::KrigeOneBlock(double blockX, double blockY, double blockZ,
+	const KrigingParameters& parameters, const Composites& composites, const IsotropicCoordinates& coordinates,
+	const VariogramModel& model, const BlockDiscretization& discretization, const DriftFunctions* drift,
+	KrigingWorkspace<MaxN>& workspace, bool computeDiagnostics)
+{
+	// Find nearest composites
+	composites.FindNearestComposites(blockX, blockY, blockZ, parameters.MaxNumComposites, parameters.MaxRadius, workspace.Neighbours);
+
+	return KrigeNeighbourhood<MaxN>(blockX, blockY, blockZ, parameters, composites, coordinates, model, discretization, drift,
+		workspace, computeDiagnostics);
+}
+
+template <int MaxN>
+bool KrigingEngine::KrigeNeighbourhood(double blockX, double blockY, double blockZ,
+	const KrigingParameters& parameters, const Composites& composites, const IsotropicCoordinates& coordinates,
+	const VariogramModel& model, const BlockDiscretization& discretization, const DriftFunctions* drift,
+	KrigingWorkspace<MaxN>& workspace, bool computeDiagnostics)
+{
+	const auto& nearestComposites = workspace.Neighbours;
+
+	// Skip block if not enough composites; universal kriging needs at least one per drift term
+	size_t minNumComposites = static_cast<size_t>(parameters.MinNumComposites);
+	if (drift != nullptr)
+	{
+		minNumComposites = std::max(minNumComposites, drift->GetNumTerms());
+	}
+	if (nearestComposites.Indices.size() < minNumComposites)
+	{
+		if (computeDiagnostics)
+		{
+			workspace.Diagnostics = KrigingDiagnostics();
+			workspace.Diagnostics.NumSamples = nearestComposites.Indices.size();
+		}
+		return false;
+	}
+
+	// Create subset of composite locations in isotropic space based on indices; workspace buffers keep their
+	// capacity between blocks
+	size_t n = nearestComposites.Indices.size();
+	workspace.X.resize(n);
+	workspace.Y.resize(n);
+	workspace.Z.resize(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		coordinates.Get(nearestComposites.Indices[i], workspace.X[i], workspace.Y[i], workspace.Z[i]);
+	}
+	double x0, y0, z0;
+	coordinates.TransformPoint(blockX, blockY, blockZ, x0, y0, z0);
+
+	// Solve the kriging system once for the neighbourhood; distances in isotropic space are plain Euclidean distances.
+	// Indicator kriging is ordinary kriging of the indicators
+	bool isSimple = parameters.Type == KrigingParameters::KrigingType::Simple;
+	if (isSimple)
+	{
+		SimpleKrigingWeights<MaxN>(x0, y0, z0, workspace.X, workspace.Y, workspace.Z,
+			model, discretization, parameters.Solver, workspace.System);
+	}
+	else if (drift != nullptr)
+	{
+		UniversalKrigingWeights<MaxN>(x0, y0, z0, workspace.X, workspace.Y, workspace.Z, nearestComposites.Indices, *drift,
+			model, discretization, parameters.Solver, workspace.System);
+	}
+	else
+	{
+		OrdinaryKrigingWeights<MaxN>(x0, y0, z0, workspace.X, workspace.Y, workspace.Z,
+			model, discretization, parameters.Solver, workspace.System);
+	}
+	const auto& weights = workspace.System.Weights;
+
+	if (parameters.Type == KrigingParameters::KrigingType::Indicator)
+	{
+		IndicatorEstimates<MaxN>(parameters.Cutoffs, composites.GetValues(0), nearestComposites.Indices, workspace);
+	}
+	else
+	{
+		// Apply the shared weights to every variable; simple kriging weights the residuals from the global mean
+		for (size_t v = 0; v < workspace.Estimates.size(); ++v)
+		{
+			const auto& values = composites.GetValues(v);
+			double krigedValue = 0.0;
+			if (isSimple)
+			{
+				double mean = parameters.GlobalMeans[v];
+				krigedValue = mean;
+				for (size_t i = 0; i < n; ++i)
+				{
+					krigedValue += weights[i] * (values[nearestComposites.Indices[i]] - mean);
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < n; ++i)
+				{
+					krigedValue += weights[i] * values[nearestComposites.Indices[i]];
+				}
+			}
+			workspace.Estimates[v] = krigedValue;
+		}
+	}
+
+	if (computeDiagnostics)
+	{
+		ComputeDiagnostics<MaxN>(workspace.System, nearestComposites.Distances, discretization, workspace.Diagnostics);
+	}
+
+	return true;
+}
+
+template <int MaxN>
+void KrigingEngine::IndicatorEstimates(const std::vector<double>& cutoffs, const std::vector<double>& values,
+	const std::vector<size_t>& indices, KrigingWorkspace<MaxN>& workspace)
+{
+	const auto& weights = workspace.System.Weights;
+	auto& ccdf = workspace.Estimates;
+	size_t numCutoffs = cutoffs.size();
+
+	// Add each weight at the first cutoff at or above the sample's value; samples above every cutoff add nothing
+	std::fill(ccdf.begin(), ccdf.end(), 0.0);
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		size_t k = std::lower_bound(cutoffs.begin(), cutoffs.end(), values[indices[i]]) - cutoffs.begin();
+		if (k < numCutoffs)
+		{
+			ccdf[k] += weights[i];
+		}
+	}
+
+	// Accumulate upwards, so each cutoff sums the weights of all samples at or below it
+	for (size_t k = 1; k < numCutoffs; ++k)
+	{
+		ccdf[k] += ccdf[k - 1];
+	}
+
+	CorrectOrderRelations(ccdf, workspace.DownwardCcdf);
+}
+
+void KrigingEngine::CorrectOrderRelations(std::vector<double>& ccdf, std::vector<double>& downward)
+{
+	size_t numCutoffs = ccdf.size();
+	for (size_t k = 0; k < numCutoffs; ++k)
+	{
+		ccdf[k] = std::clamp(ccdf[k], 0.0, 1.0);
+	}
+
+	// Downward correction: running minimum from the last cutoff
+	downward[numCutoffs - 1] = ccdf[numCutoffs - 1];
+	for (size_t k = numCutoffs - 1; k > 0; --k)
+	{
+		downward[k - 1] = std::min(ccdf[k - 1], downward[k]);
+	}
+
+	// Upward correction: running maximum from the first cutoff, averaged with the downward correction
+	double upward = 0.0;
+	for (size_t k = 0; k < numCutoffs; ++k)
+	{
+		upward = std::max(upward, ccdf[k]);
+		ccdf[k] = 0.5 * (upward + downward[k]);
+	}
+}
+
+template <int MaxN>
+void KrigingEngine::ComputeDiagnostics(const KrigingSystem<MaxN>& system, const std::vector<double>& distances,
+	const BlockDiscretization& discretization, KrigingDiagnostics& diagnostics)
+{
+	size_t n = distances.size();
+	const auto& weights = system.Weights;
+	const auto& D = system.D;
+
+	// Lagrange multipliers times constraint values, mu'f0: mu for ordinary kriging, none for simple kriging
+	double mu = 0.0;
+	for (Eigen::Index t = 0; t < system.GetNumConstraints(); ++t)
+	{
+		mu += weights(n + t) * D(n + t);
+	}
+
+	// Covariance between the estimate and the true value, w'k0; reuses the RHS already computed
+	double weightedCovariance = 0.0;
+	double sumNegativeWeights = 0.0;
+	double sumDistances = 0.0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		weightedCovariance += weights(i) * D(i);
+		sumNegativeWeights += std::min(weights(i), 0.0);
+		sumDistances += distances[i];
+	}
+
+	// Block variance C(V,V) consistent with the covariances used in the kriging system; the point variance with point support
+	double blockCovariance = discretization.GetBlockCovariance();
+
+	diagnostics.KrigingVariance = blockCovariance - weightedCovariance - mu;
+	diagnostics.SlopeOfRegression = weightedCovariance / (weightedCovariance - mu);
+	diagnostics.NumSamples = n;
+	diagnostics.AverageDistance = n > 0 ? sumDistances / n : 0.0;
+	diagnostics.SumNegativeWeights = sumNegativeWeights;
+}
 
-	// Create subset of composites based on indices
-	std::vector<double> subsetX;
-	std::vector<double> subsetY;
-	std::vector<double> subsetZ;
-	std::vector<double> subsetGrade;
+void KrigingEngine::RunKriging(Blocks& blocks, const KrigingParameters& parameters, const Composites& composites)
+{
+	if (blocks.GetNumVariables() != GetNumEstimates(parameters, composites))
+	{
+		LogAndThrow<std::invalid_argument>("Blocks must have one grade column per composite variable, or per cutoff for indicator kriging.");
+	}
 
-	for (size_t index : nearestComposites.Indices)
+	// Simple kriging means not given in the parameters are computed from the composites, once per run
+	if (IsMissingGlobalMeans(parameters))
 	{
-		subsetX.push_back(composites.GetX(index));
-		subsetY.push_back(composites.GetY(index));
-		subsetZ.push_back(composites.GetZ(index));
-		subsetGrade.push_back(composites.GetGrade(index));
+		RunKriging(blocks, WithCompositeMeans(parameters, composites), composites);
+		return;
 	}
 
-	return OrdinaryKrigingPoint(blockX, blockY, blockZ,
-		subsetX, subsetY, subsetZ, subsetGrade, parameters.VariogramParameters);
+	// Select the smallest fixed-size kernel that fits the neighbourhood; chosen once per run
+	int maxNumComposites = parameters.MaxNumComposites;
+	if (maxNumComposites <= 8)
+	{
+		RunKriging<8>(blocks, parameters, composites);
+	}
+	else if (maxNumComposites <= 16)
+	{
+		RunKriging<16>(blocks, parameters, composites);
+	}
+	else if (maxNumComposites <= 24)
+	{
+		RunKriging<24>(blocks, parameters, composites);
+	}
+	else if (maxNumComposites <= 32)
+	{
+		RunKriging<32>(blocks, parameters, composites);
+	}
+	else if (maxNumComposites <= 48)
+	{
+		RunKriging<48>(blocks, parameters, composites);
+	}
+	else
+	{
+		RunKriging<Eigen::Dynamic>(blocks, parameters, composites);
+	}
 }
 
+template <int MaxN>
 void KrigingEngine::RunKriging(Blocks& blocks, const KrigingParameters& parameters, const Composites& composites)
 {
 	std::cout << "Running kriging..." << std::endl;
+	std::cout << "Distance kernel instruction set: " << DistanceKernel::GetInstructionSet() << std::endl;
+	if (parameters.Type == KrigingParameters::KrigingType::Simple)
+	{
+		std::cout << "Simple kriging global means:";
+		for (double mean : parameters.GlobalMeans)
+		{
+			std::cout << " " << mean;
+		}
+		std::cout << std::endl;
+	}
 
 	const size_t numBlocks = blocks.GetSize();
 
-	// Process blocks in batches
-	size_t batchSize = GetThreadBatchSize(numBlocks);
-	std::vector<std::future<void>> futures;
-	for (size_t i = 0; i < numBlocks; i += batchSize)
+	ThreadPool pool(parameters.NumThreads);
+
+	if (parameters.OutputDiagnostics)
+	{
+		blocks.EnableDiagnostics();
+	}
+
+	// Compile the variogram, and transform composites into its isotropic space, once for the run
+	VariogramModel model(parameters.VariogramParameters, parameters.CovarianceTable, parameters.CovarianceTableResolution);
+	if (parameters.CovarianceTable != KrigingParameters::CovarianceTableType::None)
+	{
+		std::cout << "Covariance table maximum sampled error: " << model.GetMaxSampledTableError() << std::endl;
+	}
+	IsotropicCoordinates coordinates(composites, model.GetAnisotropy(), true, &pool);
+
+	// Discretization stencil and block variance are shared by every block
+	BlockDiscretization discretization(parameters.BlockDiscretization, blocks.GetBlockSizeX(), blocks.GetBlockSizeY(),
+		blocks.GetBlockSizeZ(), model);
+
+	// Drift terms of the composites are evaluated once, scaled over the block model
+	std::optional<DriftFunctions> driftFunctions;
+	if (parameters.Type == KrigingParameters::KrigingType::Universal)
+	{
+		size_t last = numBlocks - 1;
+		CoordinateExtents region = { blocks.GetX(0) - 0.5 * blocks.GetBlockSizeX(), blocks.GetY(0) - 0.5 * blocks.GetBlockSizeY(),
+			blocks.GetZ(0) - 0.5 * blocks.GetBlockSizeZ(), blocks.GetX(last) + 0.5 * blocks.GetBlockSizeX(),
+			blocks.GetY(last) + 0.5 * blocks.GetBlockSizeY(), blocks.GetZ(last) + 0.5 * blocks.GetBlockSizeZ() };
+		driftFunctions.emplace(coordinates, composites.GetSize(), parameters.Drift, region, true, &pool);
+	}
+	const DriftFunctions* drift = driftFunctions ? &*driftFunctions : nullptr;
+
+	// Each thread owns its workspace
+	std::vector<KrigingWorkspace<MaxN>> workspaces;
+	workspaces.reserve(pool.GetNumThreads());
+	for (size_t i = 0; i < pool.GetNumThreads(); ++i)
+	{
+		workspaces.emplace_back(parameters.MaxNumComposites, GetNumEstimates(parameters, composites));
+	}
+
+	if (parameters.SearchMode == KrigingParameters::SearchType::Tiled)
+	{
+		size_t tileSize = static_cast<size_t>(parameters.TileSize);
+		size_t numTilesI = (blocks.GetCountI() + tileSize - 1) / tileSize;
+		size_t numTilesJ = (blocks.GetCountJ() + tileSize - 1) / tileSize;
+		size_t numTilesK = (blocks.GetCountK() + tileSize - 1) / tileSize;
+
+		// Each tile is one chunk; tiles are ordered i fastest, matching the block ordering
+		auto statistics = pool.ParallelFor(numTilesI * numTilesJ * numTilesK, 1,
+			[&blocks, &parameters, &composites, &coordinates, &model, &discretization, drift, &workspaces, numTilesI, numTilesJ](size_t begin, size_t end, size_t threadIndex) {
+				for (size_t t = begin; t < end; ++t)
+				{
+					KrigeOneTile<MaxN>(t % numTilesI, (t / numTilesI) % numTilesJ, t / (numTilesI * numTilesJ),
+						blocks, parameters, composites, coordinates, model, discretization, drift, workspaces[threadIndex]);
+				}
+			});
+
+		ThreadPool::PrintStatistics(statistics, "tiles");
+	}
+	else
 	{
-		futures.push_back(std::async(std::launch::async, [&blocks, &parameters, &composites, i, batchSize, numBlocks] {
-			size_t end = std::min(i + batchSize, numBlocks);
-			for (size_t j = i; j < end; ++j)
+		// Process blocks in small chunks; idle threads steal chunks from busy ones
+		auto statistics = pool.ParallelFor(numBlocks, mBlockChunkSize,
+			[&blocks, &parameters, &composites, &coordinates, &model, &discretization, drift, &workspaces](size_t begin, size_t end, size_t threadIndex) {
+				auto& workspace = workspaces[threadIndex];
+				bool computeDiagnostics = parameters.OutputDiagnostics;
+				for (size_t j = begin; j < end; ++j)
+				{
+					bool estimated = KrigeOneBlock<MaxN>(blocks.GetX(j), blocks.GetY(j), blocks.GetZ(j), parameters, composites, coordinates,
+						model, discretization, drift, workspace, computeDiagnostics);
+					StoreBlockEstimates<MaxN>(j, estimated, workspace, blocks, computeDiagnostics);
+				}
+			});
+
+		ThreadPool::PrintStatistics(statistics, "blocks");
+	}
+
+	std::cout << "Kriging completed." << std::endl;
+}
+
+template <int MaxN>
+void KrigingEngine::KrigeOneTile(size_t tileI, size_t tileJ, size_t tileK, Blocks& blocks,
+	const KrigingParameters& parameters, const Composites& composites, const IsotropicCoordinates& coordinates,
+	const VariogramModel& model, const BlockDiscretization& discretization, const DriftFunctions* drift,
+	KrigingWorkspace<MaxN>& workspace)
+{
+	bool computeDiagnostics = parameters.OutputDiagnostics;
+	size_t tileSize = static_cast<size_t>(parameters.TileSize);
+
+	// Block index range of the tile, clipped to the grid
+	size_t beginI = tileI * tileSize, endI = std::min(beginI + tileSize, blocks.GetCountI());
+	size_t beginJ = tileJ * tileSize, endJ = std::min(beginJ + tileSize, blocks.GetCountJ());
+	size_t beginK = tileK * tileSize, endK = std::min(beginK + tileSize, blocks.GetCountK());
+
+	// Tile centre is midway between the centroids of its first and last blocks
+	size_t first = blocks.GetIndex(beginI, beginJ, beginK);
+	size_t last = blocks.GetIndex(endI - 1, endJ - 1, endK - 1);
+	double centreX = 0.5 * (blocks.GetX(first) + blocks.GetX(last));
+	double centreY = 0.5 * (blocks.GetY(first) + blocks.GetY(last));
+	double centreZ = 0.5 * (blocks.GetZ(first) + blocks.GetZ(last));
+
+	// Every composite within MaxRadius of any block centroid in the tile lies within MaxRadius plus the search
+	// distance from the tile centre to its furthest centroid. With a search ellipsoid the furthest centroid may be
+	// at any corner of the tile, so all four diagonals are measured.
+	double dx = blocks.GetX(last) - blocks.GetX(first);
+	double dy = blocks.GetY(last) - blocks.GetY(first);
+	double dz = blocks.GetZ(last) - blocks.GetZ(first);
+	double halfDiagonal = 0.5 * std::max({ composites.GetSearchDistance(dx, dy, dz), composites.GetSearchDistance(-dx, dy, dz),
+		composites.GetSearchDistance(dx, -dy, dz), composites.GetSearchDistance(dx, dy, -dz) });
+	composites.FindCandidateComposites(centreX, centreY, centreZ, parameters.MaxRadius + halfDiagonal, workspace.Candidates);
+
+	// Dense tiles are cheaper to search block by block
+	bool useCandidates = workspace.Candidates.Indices.size() <= mMaxTileCandidatesFactor * static_cast<size_t>(parameters.MaxNumComposites);
+
+	for (size_t k = beginK; k < endK; ++k)
+	{
+		for (size_t j = beginJ; j < endJ; ++j)
+		{
+			for (size_t i = beginI; i < endI; ++i)
 			{
-				blocks.Grade[j] = KrigeOneBlock(blocks.GetX(j), blocks.GetY(j), blocks.GetZ(j), parameters, composites);
+				size_t index = blocks.GetIndex(i, j, k);
+				double blockX = blocks.GetX(index);
+				double blockY = blocks.GetY(index);
+				double blockZ = blocks.GetZ(index);
+
+				bool estimated;
+				if (useCandidates)
+				{
+					composites.FindNearestCandidates(blockX, blockY, blockZ, parameters.MaxNumComposites, parameters.MaxRadius,
+						workspace.Candidates, workspace.Neighbours);
+					estimated = KrigeNeighbourhood<MaxN>(blockX, blockY, blockZ, parameters, composites, coordinates, model, discretization,
+						drift, workspace, computeDiagnostics);
+				}
+				else
+				{
+					estimated = KrigeOneBlock<MaxN>(blockX, blockY, blockZ, parameters, composites, coordinates, model, discretization,
+						drift, workspace, computeDiagnostics);
+				}
+				StoreBlockEstimates<MaxN>(index, estimated, workspace, blocks, computeDiagnostics);
 			}
-			}));
+		}
+	}
+}
+
+CrossValidationResults KrigingEngine::CrossValidate(const KrigingParameters& parameters, const Composites& composites)
+{
+	if (parameters.Type == KrigingParameters::KrigingType::Indicator)
+	{
+		LogAndThrow<std::invalid_argument>("Cross-validation does not support indicator kriging.");
 	}
 
-	// Wait for all tasks to complete
-	for (auto& fut : futures)
+	// Simple kriging means not given in the parameters are computed from the composites, once per run
+	if (IsMissingGlobalMeans(parameters))
 	{
-		fut.get();
+		return CrossValidate(WithCompositeMeans(parameters, composites), composites);
+	}
+
+	// Select the smallest fixed-size kernel that fits the neighbourhood; chosen once per run
+	int maxNumComposites = parameters.MaxNumComposites;
+	if (maxNumComposites <= 8)
+	{
+		return CrossValidate<8>(parameters, composites);
+	}
+	else if (maxNumComposites <= 16)
+	{
+		return CrossValidate<16>(parameters, composites);
+	}
+	else if (maxNumComposites <= 24)
+	{
+		return CrossValidate<24>(parameters, composites);
+	}
+	else if (maxNumComposites <= 32)
+	{
+		return CrossValidate<32>(parameters, composites);
+	}
+	else if (maxNumComposites <= 48)
+	{
+		return CrossValidate<48>(parameters, composites);
+	}
+	else
+	{
+		return CrossValidate<Eigen::Dynamic>(parameters, composites);
 	}
-	std::cout << "Kriging completed." << std::endl;
 }
 
-size_t KrigingEngine::GetThreadBatchSize(size_t numBlocks)
+template <int MaxN>
+CrossValidationResults KrigingEngine::CrossValidate(const KrigingParameters& parameters, const Composites& composites)
 {
-	size_t numThread;
-	try
+	std::cout << "Running cross-validation..." << std::endl;
+
+	size_t numComposites = composites.GetSize();
+	CrossValidationResults results(numComposites, composites.GetNumVariables());
+	if (numComposites == 0)
+	{
+		return results;
+	}
+
+	ThreadPool pool(parameters.NumThreads);
+
+	// Compile the variogram, and transform composites into its isotropic space, once for the run
+	VariogramModel model(parameters.VariogramParameters, parameters.CovarianceTable, parameters.CovarianceTableResolution);
+	IsotropicCoordinates coordinates(composites, model.GetAnisotropy(), true, &pool);
+
+	// Composites are estimated at their own locations
+	BlockDiscretization point(model);
+
+	// Drift terms of the composites are evaluated once, scaled over the composites
+	std::optional<DriftFunctions> driftFunctions;
+	if (parameters.Type == KrigingParameters::KrigingType::Universal)
 	{
-		numThread = std::thread::hardware_concurrency();
-		if (numThread == 0)
+		CoordinateExtents region = { composites.GetX(0), composites.GetY(0), composites.GetZ(0),
+			composites.GetX(0), composites.GetY(0), composites.GetZ(0) };
+		for (size_t i = 1; i < numComposites; ++i)
 		{
-			throw std::runtime_error("Unable to determine the number of threads.");
+			region.MinX = std::min(region.MinX, composites.GetX(i));
+			region.MinY = std::min(region.MinY, composites.GetY(i));
+			region.MinZ = std::min(region.MinZ, composites.GetZ(i));
+			region.MaxX = std::max(region.MaxX, composites.GetX(i));
+			region.MaxY = std::max(region.MaxY, composites.GetY(i));
+			region.MaxZ = std::max(region.MaxZ, composites.GetZ(i));
 		}
+		driftFunctions.emplace(coordinates, numComposites, parameters.Drift, region, true, &pool);
 	}
-	catch (const std::exception& e)
+	const DriftFunctions* drift = driftFunctions ? &*driftFunctions : nullptr;
+
+	size_t minNumComposites = static_cast<size_t>(parameters.MinNumComposites);
+	if (drift != nullptr)
+	{
+		minNumComposites = std::max(minNumComposites, drift->GetNumTerms());
+	}
+
+	bool crossValidated = false;
+	if (IsUniqueNeighbourhood(parameters, composites, minNumComposites))
+	{
+		crossValidated = CrossValidateUniqueNeighbourhood(parameters, composites, coordinates, model, drift, results);
+		if (crossValidated)
+		{
+			std::cout << "Unique neighbourhood; estimating all composites from one factorization" << std::endl;
+		}
+		else
+		{
+			std::cout << "Unique neighbourhood kriging matrix is singular; estimating each composite separately" << std::endl;
+		}
+	}
+
+	if (!crossValidated)
+	{
+		// Each thread owns its workspace
+		std::vector<KrigingWorkspace<MaxN>> workspaces;
+		workspaces.reserve(pool.GetNumThreads());
+		for (size_t i = 0; i < pool.GetNumThreads(); ++i)
+		{
+			workspaces.emplace_back(parameters.MaxNumComposites, composites.GetNumVariables());
+		}
+
+		// Process composites in small chunks; idle threads steal chunks from busy ones
+		auto statistics = pool.ParallelFor(numComposites, mBlockChunkSize,
+			[&parameters, &composites, &coordinates, &model, &point, drift, &workspaces, &results](size_t begin, size_t end, size_t threadIndex) {
+				auto& workspace = workspaces[threadIndex];
+				for (size_t i = begin; i < end; ++i)
+				{
+					composites.FindNeighbouringComposites(i, parameters.MaxNumComposites, parameters.MaxRadius, workspace.Neighbours);
+					bool estimated = KrigeNeighbourhood<MaxN>(composites.GetX(i), composites.GetY(i), composites.GetZ(i), parameters, composites,
+						coordinates, model, point, drift, workspace, true);
+					if (estimated)
+					{
+						for (size_t v = 0; v < workspace.Estimates.size(); ++v)
+						{
+							results.Estimates[v][i] = workspace.Estimates[v];
+						}
+						results.KrigingVariances[i] = workspace.Diagnostics.KrigingVariance;
+					}
+				}
+			});
+
+		ThreadPool::PrintStatistics(statistics, "composites");
+	}
+
+	results.ComputeStatistics(composites);
+	results.PrintStatistics(composites.GetVariableNames());
+	std::cout << "Cross-validation completed." << std::endl;
+	return results;
+}
+
+bool KrigingEngine::IsUniqueNeighbourhood(const KrigingParameters& parameters, const Composites& composites, size_t minNumComposites)
+{
+	size_t numComposites = composites.GetSize();
+	if (numComposites < 2 || numComposites - 1 > static_cast<size_t>(parameters.MaxNumComposites) || numComposites - 1 < minNumComposites)
+	{
+		return false;
+	}
+
+	// Pairs at exactly the search radius are left to the searches, which may round either way
+	for (size_t i = 0; i < numComposites; ++i)
+	{
+		for (size_t j = i + 1; j < numComposites; ++j)
+		{
+			double distance = composites.GetSearchDistance(composites.GetX(j) - composites.GetX(i), composites.GetY(j) - composites.GetY(i),
+				composites.GetZ(j) - composites.GetZ(i));
+			if (distance >= parameters.MaxRadius)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool KrigingEngine::CrossValidateUniqueNeighbourhood(const KrigingParameters& parameters, const Composites& composites,
+	const IsotropicCoordinates& coordinates, const VariogramModel& model, const DriftFunctions* drift,
+	CrossValidationResults& results)
+{
+	size_t n = composites.GetSize();
+	bool isSimple = parameters.Type == KrigingParameters::KrigingType::Simple;
+	size_t numConstraints = isSimple ? 0 : (drift != nullptr ? drift->GetNumTerms() : 1);
+	size_t size = n + numConstraints;
+
+	std::vector<double> xs(n), ys(n), zs(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		coordinates.Get(i, xs[i], ys[i], zs[i]);
+	}
+
+	// Kriging matrix of all composites, bordered by the constraints of the kriging type
+	Eigen::MatrixXd A = Eigen::MatrixXd::Zero(size, size);
+	for (size_t j = 0; j < n; ++j)
+	{
+		for (size_t i = j; i < n; ++i)
+		{
+			A(i, j) = model.Covariance(xs[j] - xs[i], ys[j] - ys[i], zs[j] - zs[i]);
+			A(j, i) = A(i, j);
+		}
+	}
+	double terms[DriftFunctions::MaxNumTerms];
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (drift != nullptr)
+		{
+			drift->Get(i, terms);
+		}
+		for (size_t t = 0; t < numConstraints; ++t)
+		{
+			A(i, n + t) = drift != nullptr ? terms[t] : 1.0;
+			A(n + t, i) = A(i, n + t);
+		}
+	}
+
+	// One factorization gives every leave-one-out system through the inverse; composites at the same location
+	// make the matrix singular, although each leave-one-out system may still be solvable
+	Eigen::ColPivHouseholderQR<Eigen::MatrixXd> qr(A);
+	if (!qr.isInvertible())
 	{
-		int defaultNumThread = 8;
-		std::cerr << "Exception caught: " << e.what() << ". Using default number of threads: " << defaultNumThread << std::endl;
-		numThread = defaultNumThread;
+		return false;
+	}
+	Eigen::MatrixXd B = qr.inverse();
+	for (size_t i = 0; i < n; ++i)
+	{
+		results.KrigingVariances[i] = 1.0 / B(i, i);
+	}
+
+	// Simple kriging estimates the residuals from the global mean
+	Eigen::VectorXd y = Eigen::VectorXd::Zero(size);
+	for (size_t v = 0; v < composites.GetNumVariables(); ++v)
+	{
+		const auto& values = composites.GetValues(v);
+		double mean = isSimple ? parameters.GlobalMeans[v] : 0.0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			y(i) = values[i] - mean;
+		}
+		Eigen::VectorXd errors = B * y;
+		for (size_t i = 0; i < n; ++i)
+		{
+			results.Estimates[v][i] = values[i] - errors(i) / B(i, i);
+		}
 	}
-	numThread = std::min(numThread, numBlocks);
+	return true;
+}
+
+bool KrigingEngine::IsMissingGlobalMeans(const KrigingParameters& parameters)
+{
+	return parameters.Type == KrigingParameters::KrigingType::Simple && parameters.GlobalMeans.empty();
+}
+
+size_t KrigingEngine::GetNumEstimates(const KrigingParameters& parameters, const Composites& composites)
+{
+	return parameters.Type == KrigingParameters::KrigingType::Indicator ? parameters.Cutoffs.size() : composites.GetNumVariables();
+}
 
-	// Round the batch size up to the nearest whole number
-	return (numBlocks + numThread - 1) / numThread;
+KrigingParameters KrigingEngine::WithCompositeMeans(const KrigingParameters& parameters, const Composites& composites)
+{
+	KrigingParameters resolved = parameters;
+	resolved.GlobalMeans.resize(composites.GetNumVariables());
+	for (size_t v = 0; v < composites.GetNumVariables(); ++v)
+	{
+		const auto& values = composites.GetValues(v);
+		double sum = 0.0;
+		for (double value : values)
+		{
+			sum += value;
+		}
+		resolved.GlobalMeans[v] = values.empty() ? 0.0 : sum / values.size();
+	}
+	return resolved;
 }
 
-double KrigingEngine::EuclideanDistance(double x1, double y1, double z1, double x2, double y2, double z2)
+template <int MaxN>
+void KrigingEngine::StoreBlockEstimates(size_t j, bool estimated, const KrigingWorkspace<MaxN>& workspace,
+	Blocks& blocks, bool computeDiagnostics)
 {
-	return sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1) + (z2 - z1) * (z2 - z1));
+	size_t numVariables = workspace.Estimates.size();
+	for (size_t v = 0; v < numVariables; ++v)
+	{
+		if (estimated)
+		{
+			blocks.Grades[v].Set(j, workspace.Estimates[v]);
+		}
+		else
+		{
+			blocks.Grades[v].Reset(j);
+		}
+	}
+	if (computeDiagnostics)
+	{
+		blocks.Diagnostics[j] = workspace.Diagnostics;
+	}
 }
\ No newline at end of file
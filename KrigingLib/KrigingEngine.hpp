@@ -1,7 +1,6 @@
 #pragma once
 
 #include <vector>
-#include <future>
 #include <cmath>
 #include <iostream>
 
@@ -9,6 +8,16 @@
 #include "Blocks.hpp"
 #include "Composites.hpp"
 #include "KrigingParameters.hpp"
+#include "KrigingSystem.hpp"
+#include "KrigingWorkspace.hpp"
+#include "Anisotropy.hpp"
+#include "IsotropicCoordinates.hpp"
+#include "VariogramModel.hpp"
+#include "BlockDiscretization.hpp"
+#include "DriftFunctions.hpp"
+#include "CrossValidation.hpp"
+#include "DistanceKernel.hpp"
+#include "ThreadPool.hpp"
 
 /**
 * @brief Class containing variogram and kriging calculation methods.
@@ -25,7 +34,9 @@ public:
    /**
     * @brief Calculates the variogram value for a given pair of points.
     *
-    * @param h Euclidean distance between pair of points in 3D space.
+    * Compiles a VariogramModel per call; use VariogramModel directly for repeated evaluations.
+    *
+    * @param h Lag distance along the major axis of each structure, i.e. in the variogram's isotropic space (see Anisotropy).
     * @param parameters Variogram parameters.
     * @return Variogram value.
     */
@@ -34,7 +45,9 @@ public:
    /**
     * @brief Calculates the covariance for a given pair of points.
     *
-    * @param h Euclidean distance between pair of points in 3D space.
+    * Compiles a VariogramModel per call; use VariogramModel directly for repeated evaluations.
+    *
+    * @param h Lag distance along the major axis of each structure, i.e. in the variogram's isotropic space (see Anisotropy).
     * @param parameters Variogram parameters.
     * @return Covariance value.
     */
@@ -43,30 +56,55 @@ public:
    /**
     * @brief Performs ordinary kriging for a point p0 given nearest samples.
     *
+    * Coordinates are in model space; the first variogram structure's anisotropy is applied to them before kriging.
+    *
     * @param x0,y0,z0 X,Y,Z value of unknown point p0 to be krigged.
     * @param xs,ys,zs X,Y,Z values of known sample points.
     * @param values Grade values of known sample points.
     * @param parameters Variogram parameters.
+    * @param solver Solver used for the kriging system.
     * @return Krigged value at point p0.
     */
    static double OrdinaryKrigingPoint(double x0, double y0, double z0,
       const std::vector<double>& xs, const std::vector<double>& ys, const std::vector<double>& zs,
-      const std::vector<double>& values, const VariogramParameters& parameters);
+      const std::vector<double>& values, const VariogramParameters& parameters,
+      KrigingParameters::SolverType solver = KrigingParameters::SolverType::Cholesky);
 
    /**
     * @brief Retrieves composites for the current block in preparation for kriging. 
     *
+    * The kriging system is solved once and its weights are applied to every composite variable. Simple kriging
+    * without parameters.GlobalMeans uses the mean of each variable over all composites. Indicator kriging applies
+    * the weights to the indicator of every cutoff, giving the block's order relation corrected CCDF. Blocks are
+    * discretized as set by parameters.BlockDiscretization, with the block size of parameters.BlockParameters.
+    *
     * @param blockX,blockY,blockZ X,Y,Z centroid of block.
     * @param parameters Kriging parameters.
     * @param composites Composites.
-    * @return Block krigged value.
+    * @param diagnostics Optional output for the block's kriging diagnostics.
+    * @return Block krigged values, one per composite variable or per indicator cutoff; nullopt if there are too few composites.
     */
-   static std::optional<double> KrigeOneBlock(double blockX, double blockY, double blockZ,
-      const KrigingParameters& parameters, const Composites& composites);
+   static std::optional<std::vector<double>> KrigeOneBlock(double blockX, double blockY, double blockZ,
+      const KrigingParameters& parameters, const Composites& composites, KrigingDiagnostics* diagnostics = nullptr);
 
    /**
     * @brief Runs kriging for all provided blocks using parallelization.
     *
+    * Blocks are processed in small chunks on a work-stealing thread pool with parameters.NumThreads threads.
+    * A fixed-size kernel is selected once per run from parameters.MaxNumComposites (8, 16, 24, 32 or 48),
+    * so the per-block kriging systems are stack allocated. Larger neighbourhoods use a dynamic kernel.
+    * The variogram is compiled into a VariogramModel once per run, with covariance tables if parameters.CovarianceTable
+    * is set; the tables' worst-case error is written to the console. The block discretization stencil and block
+    * variance are also computed once per run, as all blocks have the same size.
+    * Simple kriging without parameters.GlobalMeans uses the mean of each variable over all composites,
+    * computed once per run.
+    * Universal kriging evaluates the drift terms of all composites once per run, scaled over the block model.
+    * Indicator kriging solves one ordinary kriging system per block for all cutoffs, as every indicator shares the
+    * median indicator variogram, and blocks must have one grade column per cutoff.
+    *
+    * With the tiled search mode, blocks are grouped into tiles of parameters.TileSize blocks per edge. Composites
+    * are searched once per tile with a radius enlarged to cover every block in the tile, and each block then
+    * selects its nearest composites from the tile's candidates. Results match the per-block search.
     * 
     * @param blocks Ref class containing list of block information.
     * @param parameters Ref class containing parameters for kriging.
@@ -75,16 +113,220 @@ public:
     */
    static void RunKriging(Blocks& blocks, const KrigingParameters& parameters, const Composites& composites);
 
+   /**
+    * @brief Cross-validates by leave-one-out: re-estimates every composite from its neighbours, excluding itself.
+    *
+    * Each composite's neighbours are found by one kd-tree search that skips the composite, and composites are
+    * processed in parallel on a work-stealing thread pool. Estimates use point support at the composite and the
+    * kriging type, neighbourhood and variogram of the parameters, so the error statistics can be compared across
+    * e.g. parameters.MinNumComposites, MaxNumComposites and MaxRadius. Indicator kriging is not supported.
+    *
+    * If every composite's neighbourhood holds all the other composites (a unique neighbourhood), all estimates come
+    * from one factorization of the full kriging matrix A instead: with B = inverse(A) and y the composite values
+    * padded with zeros for the constraints, the error at composite i is (B y)_i / B_ii and its kriging variance is
+    * 1 / B_ii (Dubrule 1983).
+    *
+    * @param parameters Ref class containing parameters for kriging; the block model is not used.
+    * @param composites Ref class containing composite information.
+    * @return Estimates, kriging variances and error statistics per variable.
+    */
+   static CrossValidationResults CrossValidate(const KrigingParameters& parameters, const Composites& composites);
+
 private:
+   // Number of blocks per work-stealing chunk; small enough to balance dense and sparse areas
+   static constexpr size_t mBlockChunkSize = 64;
+
+   // Tiles with more candidates than this multiple of MaxNumComposites fall back to per-block kd-tree searches,
+   // as scanning the candidates would cost more than the searches it saves
+   static constexpr size_t mMaxTileCandidatesFactor = 64;
+
+   /**
+    * @brief Runs kriging for all provided blocks using the kernel with maximum neighbourhood size MaxN.
+    */
+   template <int MaxN>
+   static void RunKriging(Blocks& blocks, const KrigingParameters& parameters, const Composites& composites);
+
+   /**
+    * @brief Cross-validates the composites using the kernel with maximum neighbourhood size MaxN.
+    */
+   template <int MaxN>
+   static CrossValidationResults CrossValidate(const KrigingParameters& parameters, const Composites& composites);
+
+   /**
+    * @brief True if every composite's neighbourhood holds all the other composites: they fit in one neighbourhood,
+    * all pairs are within the search radius, and there are enough of them to estimate.
+    */
+   static bool IsUniqueNeighbourhood(const KrigingParameters& parameters, const Composites& composites, size_t minNumComposites);
+
+   /**
+    * @brief Computes the leave-one-out estimates of a unique neighbourhood from the inverse of the full kriging matrix.
+    *
+    * @param drift Drift terms of the composites for universal kriging; nullptr for other kriging types.
+    * @param results Output estimates and kriging variances; unchanged if the matrix is singular.
+    * @return False if the kriging matrix is singular, e.g. with composites at the same location.
+    */
+   static bool CrossValidateUniqueNeighbourhood(const KrigingParameters& parameters, const Composites& composites,
+      const IsotropicCoordinates& coordinates, const VariogramModel& model, const DriftFunctions* drift,
+      CrossValidationResults& results);
+
+   /**
+    * @brief Retrieves composites for the current block and krigs it using the kernel with maximum neighbourhood size MaxN.
+    *
+    * @param drift Drift terms of the composites for universal kriging; nullptr for other kriging types.
+    * @param workspace Thread-owned buffers for the neighbour search and kriging system; receives the estimates,
+    * and the diagnostics if computeDiagnostics is true.
+    * @return False if there are too few composites to estimate the block.
+    */
+   template <int MaxN>
+   static bool KrigeOneBlock(double blockX, double blockY, double blockZ,
+      const KrigingParameters& parameters, const Composites& composites, const IsotropicCoordinates& coordinates,
+      const VariogramModel& model, const BlockDiscretization& discretization, const DriftFunctions* drift,
+      KrigingWorkspace<MaxN>& workspace, bool computeDiagnostics);
+
+   /**
+    * @brief Krigs the current block from the composites already found in workspace.Neighbours.
+    *
+    * @return False if there are too few composites to estimate the block.
+    */
+   template <int MaxN>
+   static bool KrigeNeighbourhood(double blockX, double blockY, double blockZ,
+      const KrigingParameters& parameters, const Composites& composites, const IsotropicCoordinates& coordinates,
+      const VariogramModel& model, const BlockDiscretization& discretization, const DriftFunctions* drift,
+      KrigingWorkspace<MaxN>& workspace, bool computeDiagnostics);
+
+   /**
+    * @brief Krigs all blocks of one tile, searching composites once for the whole tile.
+    *
+    * @param tileI,tileJ,tileK Grid position of the tile, in tiles.
+    */
+   template <int MaxN>
+   static void KrigeOneTile(size_t tileI, size_t tileJ, size_t tileK, Blocks& blocks,
+      const KrigingParameters& parameters, const Composites& composites, const IsotropicCoordinates& coordinates,
+      const VariogramModel& model, const BlockDiscretization& discretization, const DriftFunctions* drift,
+      KrigingWorkspace<MaxN>& workspace);
+
+   /**
+    * @brief Stores the estimates and diagnostics of block j from the workspace.
+    */
+   template <int MaxN>
+   static void StoreBlockEstimates(size_t j, bool estimated, const KrigingWorkspace<MaxN>& workspace,
+      Blocks& blocks, bool computeDiagnostics);
+
+   /**
+    * @brief Performs ordinary kriging for a point p0 using the kernel with maximum neighbourhood size MaxN.
+    *
+    * The number of samples must not exceed MaxN.
+    *
+    * @param system Kriging system storage, reused between calls.
+    */
+   template <int MaxN>
+   static double OrdinaryKrigingPoint(double x0, double y0, double z0,
+      const std::vector<double>& xs, const std::vector<double>& ys, const std::vector<double>& zs,
+      const std::vector<double>& values, const VariogramModel& model, const BlockDiscretization& discretization,
+      KrigingParameters::SolverType solver, KrigingSystem<MaxN>& system);
+
    /**
-    * @brief Determines the number of threads to use based on the system processor information and number of blocks.
+    * @brief Builds and solves the ordinary kriging system for the block centred on p0; the weights are left in system.Weights.
     *
-    * Default 8 threads if system information is unknown. 
+    * The right-hand side holds average sample-block covariances over the discretization points; with point
+    * support this is point kriging at p0.
+    *
+    * The weights depend only on the sample locations and the variogram, so they can be shared by every
+    * variable that uses the same (or a proportional) variogram.
     */
-   static size_t GetThreadBatchSize(size_t numBlocks);
+   template <int MaxN>
+   static void OrdinaryKrigingWeights(double x0, double y0, double z0,
+      const std::vector<double>& xs, const std::vector<double>& ys, const std::vector<double>& zs,
+      const VariogramModel& model, const BlockDiscretization& discretization, KrigingParameters::SolverType solver,
+      KrigingSystem<MaxN>& system);
 
    /**
-    * @brief Calculates the Euclidean distance between points p1 and p2.
+    * @brief Builds and solves the simple kriging system for the block centred on p0; the weights are left in system.Weights.
+    *
+    * The system is the symmetric positive definite covariance matrix alone, without the Lagrange row, so it is
+    * smaller than the ordinary kriging system and is solved directly by the Cholesky solver.
+    */
+   template <int MaxN>
+   static void SimpleKrigingWeights(double x0, double y0, double z0,
+      const std::vector<double>& xs, const std::vector<double>& ys, const std::vector<double>& zs,
+      const VariogramModel& model, const BlockDiscretization& discretization, KrigingParameters::SolverType solver,
+      KrigingSystem<MaxN>& system);
+
+   /**
+    * @brief Builds and solves the universal kriging system for the block centred on p0; the weights are left in system.Weights.
+    *
+    * The covariances are bordered by the drift terms of each sample, copied from the precomputed drift, and the
+    * right-hand side by the drift terms averaged over the block.
+    *
+    * @param indices Composite index of each sample, for its drift terms.
+    */
+   template <int MaxN>
+   static void UniversalKrigingWeights(double x0, double y0, double z0,
+      const std::vector<double>& xs, const std::vector<double>& ys, const std::vector<double>& zs,
+      const std::vector<size_t>& indices, const DriftFunctions& drift, const VariogramModel& model,
+      const BlockDiscretization& discretization, KrigingParameters::SolverType solver, KrigingSystem<MaxN>& system);
+
+   /**
+    * @brief Applies the solved weights to the indicators of every cutoff, giving the block's CCDF in workspace.Estimates.
+    *
+    * A sample's indicator is one at every cutoff at or above its value, so its weight is added once, at the first
+    * such cutoff, and the CCDF is the running sum over cutoffs: O(n log K + K) rather than O(n K) for K cutoffs.
+    *
+    * @param values Values of the indicator variable for all composites.
+    */
+   template <int MaxN>
+   static void IndicatorEstimates(const std::vector<double>& cutoffs, const std::vector<double>& values,
+      const std::vector<size_t>& indices, KrigingWorkspace<MaxN>& workspace);
+
+   /**
+    * @brief Corrects order relation deviations of a CCDF in place.
+    *
+    * Values are clipped to [0, 1], then replaced by the average of the upward (running maximum) and downward
+    * (running minimum from the last cutoff) corrections, as in GSLIB.
+    *
+    * @param downward Scratch space for ccdf.size() values.
+    */
+   static void CorrectOrderRelations(std::vector<double>& ccdf, std::vector<double>& downward);
+
+   /**
+    * @brief Get number of estimates per block: one per variable, or one per cutoff for indicator kriging
+    */
+   static size_t GetNumEstimates(const KrigingParameters& parameters, const Composites& composites);
+
+   /**
+    * @brief Fills the n x n sample covariances of system.C and the n sample-block covariances of system.D.
+    *
+    * Only the lower triangle of the symmetric covariance matrix is computed, a column at a time with vectorized
+    * distances, and then mirrored. The system must already be resized for n samples.
+    */
+   template <int MaxN>
+   static void FillCovariances(double x0, double y0, double z0,
+      const std::vector<double>& xs, const std::vector<double>& ys, const std::vector<double>& zs,
+      const VariogramModel& model, const BlockDiscretization& discretization, KrigingSystem<MaxN>& system);
+
+   /**
+    * @brief True for simple kriging parameters without global means, which are then computed from the composites.
+    */
+   static bool IsMissingGlobalMeans(const KrigingParameters& parameters);
+
+   /**
+    * @brief Returns a copy of the parameters with the composite mean of each variable as its global mean.
+    */
+   static KrigingParameters WithCompositeMeans(const KrigingParameters& parameters, const Composites& composites);
+
+   /**
+    * @brief Computes kriging diagnostics from a solved ordinary or simple kriging system.
+    *
+    * With the system K * w + mu = k0, sum(w) = 1, the kriging variance is C(V,V) - w'k0 - mu, and the slope of
+    * regression is Cov(Z, Z*) / Var(Z*) = w'k0 / (w'k0 - mu). Universal kriging replaces mu by mu'f0 over its
+    * drift terms, and simple kriging has no mu, so its slope is one.
+    *
+    * @param system Solved kriging system.
+    * @param distances Distances from the estimation point to each sample.
+    * @param discretization Block support, whose C(V,V) replaces the point variance for block kriging.
+    * @param diagnostics Output diagnostics.
     */
-   static inline double EuclideanDistance(double x1, double y1, double z1, double x2, double y2, double z2);
+   template <int MaxN>
+   static void ComputeDiagnostics(const KrigingSystem<MaxN>& system, const std::vector<double>& distances,
+      const BlockDiscretization& discretization, KrigingDiagnostics& diagnostics);
 };
\ No newline at end of file
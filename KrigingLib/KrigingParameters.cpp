@@ -22,6 +22,25 @@ VariogramParameters::StructureType VariogramParameters::StringToStructureType(st
 	}
 }
 
+std::vector<VariogramParameters::NestedStructure> VariogramParameters::GetStructures() const
+{
+	if (!NestedStructures.empty())
+	{
+		return NestedStructures;
+	}
+
+	NestedStructure structure;
+	structure.Structure = Structure;
+	structure.Contribution = Sill - Nugget;
+	structure.Range = Range;
+	structure.RangeSemiMajor = RangeSemiMajor;
+	structure.RangeMinor = RangeMinor;
+	structure.Azimuth = Azimuth;
+	structure.Dip = Dip;
+	structure.Plunge = Plunge;
+	return { structure };
+}
+
 void KrigingParameters::SerializeParameters(const std::string& filePath)
 {
 	std::cout << "Reading kriging parameters from file: " + filePath << std::endl;
@@ -75,14 +94,236 @@ void KrigingParameters::SerializeParameters(const std::string& filePath)
 			std::cout << "Warning: Parameter 'MaxNumComposites' not found in JSON. Using default: " << mDefaultMaxNumComposites << std::endl;
 		}
 
+		if (j.contains("Solver"))
+		{
+			Solver = StringToSolverType(j.at("Solver").get<std::string>());
+		}
+		else
+		{
+			Solver = mDefaultSolver;
+			std::cout << "Warning: Parameter 'Solver' not found in JSON. Using default: Cholesky" << std::endl;
+		}
+
+		if (j.contains("NumThreads"))
+		{
+			NumThreads = j.at("NumThreads").get<int>();
+		}
+		else
+		{
+			NumThreads = mDefaultNumThreads;
+			std::cout << "Warning: Parameter 'NumThreads' not found in JSON. Using default: " << mDefaultNumThreads << " (all hardware threads)" << std::endl;
+		}
+
+		if (j.contains("Variables"))
+		{
+			Variables = j.at("Variables").get<std::vector<std::string>>();
+		}
+		else
+		{
+			Variables = mDefaultVariables;
+			std::cout << "Warning: Parameter 'Variables' not found in JSON. Using default: Grade" << std::endl;
+		}
+
+		if (j.contains("GlobalMeans"))
+		{
+			GlobalMeans = j.at("GlobalMeans").get<std::vector<double>>();
+		}
+		else
+		{
+			GlobalMeans = mDefaultGlobalMeans;
+			std::cout << "Warning: Parameter 'GlobalMeans' not found in JSON. Using default: composite means" << std::endl;
+		}
+
+		if (j.contains("Drift"))
+		{
+			Drift = StringToDriftType(j.at("Drift").get<std::string>());
+		}
+		else
+		{
+			Drift = mDefaultDrift;
+			std::cout << "Warning: Parameter 'Drift' not found in JSON. Using default: Linear" << std::endl;
+		}
+
+		if (j.contains("Cutoffs"))
+		{
+			Cutoffs = j.at("Cutoffs").get<std::vector<double>>();
+		}
+		else
+		{
+			Cutoffs = mDefaultCutoffs;
+			std::cout << "Warning: Parameter 'Cutoffs' not found in JSON. Using default: none" << std::endl;
+		}
+
+		if (j.contains("OutputDiagnostics"))
+		{
+			OutputDiagnostics = j.at("OutputDiagnostics").get<bool>();
+		}
+		else
+		{
+			OutputDiagnostics = mDefaultOutputDiagnostics;
+			std::cout << "Warning: Parameter 'OutputDiagnostics' not found in JSON. Using default: false" << std::endl;
+		}
+
+		if (j.contains("CrossValidation"))
+		{
+			CrossValidation = j.at("CrossValidation").get<bool>();
+		}
+		else
+		{
+			CrossValidation = mDefaultCrossValidation;
+			std::cout << "Warning: Parameter 'CrossValidation' not found in JSON. Using default: false" << std::endl;
+		}
+
+		if (j.contains("CacheComposites"))
+		{
+			CacheComposites = j.at("CacheComposites").get<bool>();
+		}
+		else
+		{
+			CacheComposites = mDefaultCacheComposites;
+			std::cout << "Warning: Parameter 'CacheComposites' not found in JSON. Using default: false" << std::endl;
+		}
+
+		if (j.contains("GradePrecision"))
+		{
+			GradePrecision = StringToPrecisionType(j.at("GradePrecision").get<std::string>());
+		}
+		else
+		{
+			GradePrecision = mDefaultGradePrecision;
+			std::cout << "Warning: Parameter 'GradePrecision' not found in JSON. Using default: Double" << std::endl;
+		}
+
+		if (j.contains("SearchMode"))
+		{
+			SearchMode = StringToSearchType(j.at("SearchMode").get<std::string>());
+		}
+		else
+		{
+			SearchMode = mDefaultSearchMode;
+			std::cout << "Warning: Parameter 'SearchMode' not found in JSON. Using default: PerBlock" << std::endl;
+		}
+
+		if (j.contains("TileSize"))
+		{
+			TileSize = j.at("TileSize").get<int>();
+		}
+		else
+		{
+			TileSize = mDefaultTileSize;
+			std::cout << "Warning: Parameter 'TileSize' not found in JSON. Using default: " << mDefaultTileSize << std::endl;
+		}
+
+		if (j.contains("KdTreeLeafSize"))
+		{
+			KdTreeLeafSize = j.at("KdTreeLeafSize").get<int>();
+		}
+		else
+		{
+			KdTreeLeafSize = mDefaultKdTreeLeafSize;
+			std::cout << "Warning: Parameter 'KdTreeLeafSize' not found in JSON. Using default: " << mDefaultKdTreeLeafSize << std::endl;
+		}
+
+		if (j.contains("SearchEllipsoid"))
+		{
+			auto& ellipsoid = j.at("SearchEllipsoid");
+			SearchEllipsoid.RangeSemiMajor = ellipsoid.contains("RangeSemiMajor") ? ellipsoid.at("RangeSemiMajor").get<double>() : 0.0;
+			SearchEllipsoid.RangeMinor = ellipsoid.contains("RangeMinor") ? ellipsoid.at("RangeMinor").get<double>() : 0.0;
+			SearchEllipsoid.Azimuth = ellipsoid.contains("Azimuth") ? ellipsoid.at("Azimuth").get<double>() : 0.0;
+			SearchEllipsoid.Dip = ellipsoid.contains("Dip") ? ellipsoid.at("Dip").get<double>() : 0.0;
+			SearchEllipsoid.Plunge = ellipsoid.contains("Plunge") ? ellipsoid.at("Plunge").get<double>() : 0.0;
+		}
+		else
+		{
+			SearchEllipsoid = mDefaultSearchEllipsoid;
+			std::cout << "Warning: Parameter 'SearchEllipsoid' not found in JSON. Using default: sphere of radius MaxRadius" << std::endl;
+		}
+
+		if (j.contains("CovarianceTable"))
+		{
+			CovarianceTable = StringToCovarianceTableType(j.at("CovarianceTable").get<std::string>());
+		}
+		else
+		{
+			CovarianceTable = mDefaultCovarianceTable;
+			std::cout << "Warning: Parameter 'CovarianceTable' not found in JSON. Using default: None" << std::endl;
+		}
+
+		if (j.contains("CovarianceTableResolution"))
+		{
+			CovarianceTableResolution = j.at("CovarianceTableResolution").get<int>();
+		}
+		else
+		{
+			CovarianceTableResolution = mDefaultCovarianceTableResolution;
+			std::cout << "Warning: Parameter 'CovarianceTableResolution' not found in JSON. Using default: " << mDefaultCovarianceTableResolution << std::endl;
+		}
+
+		if (j.contains("BlockDiscretization"))
+		{
+			auto& discretization = j.at("BlockDiscretization");
+			BlockDiscretization.CountI = discretization.contains("CountI") ? discretization.at("CountI").get<int>() : 1;
+			BlockDiscretization.CountJ = discretization.contains("CountJ") ? discretization.at("CountJ").get<int>() : 1;
+			BlockDiscretization.CountK = discretization.contains("CountK") ? discretization.at("CountK").get<int>() : 1;
+		}
+		else
+		{
+			BlockDiscretization = mDefaultBlockDiscretization;
+			std::cout << "Warning: Parameter 'BlockDiscretization' not found in JSON. Using default: 1 x 1 x 1 (point kriging)" << std::endl;
+		}
+
 		// Serialize required parameters
 		MaxRadius = j.at("MaxRadius").get<double>();
 
 		auto& varParams = j.at("VariogramParameters");
 		VariogramParameters.Nugget = varParams.at("Nugget").get<double>();
-		VariogramParameters.Sill = varParams.at("Sill").get<double>();
-		VariogramParameters.Range = varParams.at("Range").get<double>();
-		VariogramParameters.Structure = VariogramParameters.StringToStructureType(varParams.at("StructureType").get<std::string>());
+		VariogramParameters.NestedStructures.clear();
+		if (varParams.contains("Structures"))
+		{
+			// Nested structures; the sill and single structure fields are derived from them
+			double sill = VariogramParameters.Nugget;
+			for (auto& structureParams : varParams.at("Structures"))
+			{
+				VariogramParameters::NestedStructure structure;
+				structure.Structure = VariogramParameters.StringToStructureType(structureParams.at("StructureType").get<std::string>());
+				structure.Contribution = structureParams.at("Contribution").get<double>();
+				structure.Range = structureParams.at("Range").get<double>();
+				structure.RangeSemiMajor = structureParams.contains("RangeSemiMajor") ? structureParams.at("RangeSemiMajor").get<double>() : structure.Range;
+				structure.RangeMinor = structureParams.contains("RangeMinor") ? structureParams.at("RangeMinor").get<double>() : structure.Range;
+				structure.Azimuth = structureParams.contains("Azimuth") ? structureParams.at("Azimuth").get<double>() : 0.0;
+				structure.Dip = structureParams.contains("Dip") ? structureParams.at("Dip").get<double>() : 0.0;
+				structure.Plunge = structureParams.contains("Plunge") ? structureParams.at("Plunge").get<double>() : 0.0;
+				VariogramParameters.NestedStructures.push_back(structure);
+				sill += structure.Contribution;
+			}
+			if (VariogramParameters.NestedStructures.empty())
+			{
+				LogAndThrow<std::invalid_argument>("At least one variogram structure is required.");
+			}
+
+			const auto& first = VariogramParameters.NestedStructures.front();
+			VariogramParameters.Sill = sill;
+			VariogramParameters.Range = first.Range;
+			VariogramParameters.Structure = first.Structure;
+			VariogramParameters.RangeSemiMajor = first.RangeSemiMajor;
+			VariogramParameters.RangeMinor = first.RangeMinor;
+			VariogramParameters.Azimuth = first.Azimuth;
+			VariogramParameters.Dip = first.Dip;
+			VariogramParameters.Plunge = first.Plunge;
+		}
+		else
+		{
+			VariogramParameters.Sill = varParams.at("Sill").get<double>();
+			VariogramParameters.Range = varParams.at("Range").get<double>();
+			VariogramParameters.Structure = VariogramParameters.StringToStructureType(varParams.at("StructureType").get<std::string>());
+
+			// Optional anisotropy; isotropic by default
+			VariogramParameters.RangeSemiMajor = varParams.contains("RangeSemiMajor") ? varParams.at("RangeSemiMajor").get<double>() : VariogramParameters.Range;
+			VariogramParameters.RangeMinor = varParams.contains("RangeMinor") ? varParams.at("RangeMinor").get<double>() : VariogramParameters.Range;
+			VariogramParameters.Azimuth = varParams.contains("Azimuth") ? varParams.at("Azimuth").get<double>() : 0.0;
+			VariogramParameters.Dip = varParams.contains("Dip") ? varParams.at("Dip").get<double>() : 0.0;
+			VariogramParameters.Plunge = varParams.contains("Plunge") ? varParams.at("Plunge").get<double>() : 0.0;
+		}
 
 		auto& blockInfo = j.at("BlockModelInfo");
 		auto& coordExtents = blockInfo.at("CoordinateExtents");
@@ -105,6 +346,35 @@ void KrigingParameters::SerializeParameters(const std::string& filePath)
 	std::cout << "Kriging parameters successfully read." << std::endl;
 }
 
+Anisotropy KrigingParameters::GetSearchAnisotropy() const
+{
+	return Anisotropy(MaxRadius, SearchEllipsoid.RangeSemiMajor, SearchEllipsoid.RangeMinor,
+		SearchEllipsoid.Azimuth, SearchEllipsoid.Dip, SearchEllipsoid.Plunge);
+}
+
+double KrigingParameters::GetMaxSearchRange() const
+{
+	return std::max({ MaxRadius, SearchEllipsoid.RangeSemiMajor, SearchEllipsoid.RangeMinor });
+}
+
+std::vector<std::string> KrigingParameters::GetEstimateNames() const
+{
+	if (Type != KrigingType::Indicator)
+	{
+		return Variables;
+	}
+
+	std::vector<std::string> names;
+	names.reserve(Cutoffs.size());
+	for (double cutoff : Cutoffs)
+	{
+		std::ostringstream name;
+		name << Variables[0] << "<=" << cutoff;
+		names.push_back(name.str());
+	}
+	return names;
+}
+
 void KrigingParameters::ValidateParameters()
 {
 	ValidateKrigingParameters();
@@ -126,6 +396,66 @@ void KrigingParameters::ValidateKrigingParameters()
 	{
 		LogAndThrow<std::invalid_argument>("Maximum radius must be greater than zero.");
 	}
+	if (NumThreads < 0)
+	{
+		LogAndThrow<std::invalid_argument>("Number of threads cannot be negative.");
+	}
+	if (Variables.empty())
+	{
+		LogAndThrow<std::invalid_argument>("At least one variable is required.");
+	}
+	if (!GlobalMeans.empty() && GlobalMeans.size() != Variables.size())
+	{
+		LogAndThrow<std::invalid_argument>("Global means must have one value per variable.");
+	}
+	if (Type == KrigingType::Universal && static_cast<size_t>(MaxNumComposites) < GetNumDriftTerms(Drift))
+	{
+		LogAndThrow<std::invalid_argument>("Maximum number of composites must be at least the number of drift terms ("
+			+ std::to_string(GetNumDriftTerms(Drift)) + ") for universal kriging.");
+	}
+	if (Type == KrigingType::Indicator)
+	{
+		if (Variables.size() != 1)
+		{
+			LogAndThrow<std::invalid_argument>("Indicator kriging requires exactly one variable.");
+		}
+		if (Cutoffs.empty())
+		{
+			LogAndThrow<std::invalid_argument>("Indicator kriging requires at least one cutoff.");
+		}
+		if (std::adjacent_find(Cutoffs.begin(), Cutoffs.end(), std::greater_equal<double>()) != Cutoffs.end())
+		{
+			LogAndThrow<std::invalid_argument>("Indicator kriging cutoffs must be strictly increasing.");
+		}
+		if (CrossValidation)
+		{
+			LogAndThrow<std::invalid_argument>("Cross-validation does not support indicator kriging.");
+		}
+	}
+	if (TileSize < 1)
+	{
+		LogAndThrow<std::invalid_argument>("Tile size must be at least one block.");
+	}
+	if (KdTreeLeafSize < 1)
+	{
+		LogAndThrow<std::invalid_argument>("Kd-tree leaf size must be at least one composite.");
+	}
+	if (CovarianceTableResolution < 1)
+	{
+		LogAndThrow<std::invalid_argument>("Covariance table resolution must be at least one entry per range.");
+	}
+	if (BlockDiscretization.CountI < 1 || BlockDiscretization.CountJ < 1 || BlockDiscretization.CountK < 1)
+	{
+		LogAndThrow<std::invalid_argument>("Block discretization must have at least one point along each axis.");
+	}
+	if (SearchEllipsoid.RangeSemiMajor < 0 || SearchEllipsoid.RangeMinor < 0)
+	{
+		LogAndThrow<std::invalid_argument>("Search ellipsoid semi-major and minor ranges cannot be negative.");
+	}
+	if (SearchEllipsoid.Azimuth < 0 || SearchEllipsoid.Azimuth >= 360)
+	{
+		LogAndThrow<std::invalid_argument>("Search ellipsoid azimuth must be between 0 and 360 degrees.");
+	}
 }
 
 void KrigingParameters::ValidateVariogramParameters()
@@ -142,6 +472,33 @@ void KrigingParameters::ValidateVariogramParameters()
 	{
 		LogAndThrow<std::invalid_argument>("Variogram range must be greater than zero.");
 	}
+	if (VariogramParameters.RangeSemiMajor < 0 || VariogramParameters.RangeMinor < 0)
+	{
+		LogAndThrow<std::invalid_argument>("Variogram semi-major and minor ranges cannot be negative.");
+	}
+	if (VariogramParameters.Azimuth < 0 || VariogramParameters.Azimuth >= 360)
+	{
+		LogAndThrow<std::invalid_argument>("Variogram azimuth must be between 0 and 360 degrees.");
+	}
+	for (const auto& structure : VariogramParameters.NestedStructures)
+	{
+		if (structure.Contribution <= 0)
+		{
+			LogAndThrow<std::invalid_argument>("Variogram structure contributions must be greater than zero.");
+		}
+		if (structure.Range < mDoubleValMin)
+		{
+			LogAndThrow<std::invalid_argument>("Variogram structure ranges must be greater than zero.");
+		}
+		if (structure.RangeSemiMajor < 0 || structure.RangeMinor < 0)
+		{
+			LogAndThrow<std::invalid_argument>("Variogram structure semi-major and minor ranges cannot be negative.");
+		}
+		if (structure.Azimuth < 0 || structure.Azimuth >= 360)
+		{
+			LogAndThrow<std::invalid_argument>("Variogram structure azimuth must be between 0 and 360 degrees.");
+		}
+	}
 }
 
 void KrigingParameters::ValidateBlockParameters()
@@ -174,9 +531,114 @@ KrigingParameters::KrigingType KrigingParameters::StringToKrigingType(std::strin
 	{
 		return KrigingType::Ordinary;
 	}
+	else if (string == "simple")
+	{
+		return KrigingType::Simple;
+	}
+	else if (string == "universal")
+	{
+		return KrigingType::Universal;
+	}
+	else if (string == "indicator")
+	{
+		return KrigingType::Indicator;
+	}
 	else
 	{
 		LogAndThrow<std::invalid_argument>("Unknown kriging type: " + string);
 	}
-	// TODO: Add more kriging types once implemented
+}
+
+KrigingParameters::SolverType KrigingParameters::StringToSolverType(std::string string)
+{
+	// Transform to lower case
+	std::transform(string.begin(), string.end(), string.begin(), tolower);
+	if (string == "cholesky")
+	{
+		return SolverType::Cholesky;
+	}
+	else if (string == "qr")
+	{
+		return SolverType::QR;
+	}
+	else
+	{
+		LogAndThrow<std::invalid_argument>("Unknown solver type: " + string);
+	}
+}
+
+KrigingParameters::DriftType KrigingParameters::StringToDriftType(std::string string)
+{
+	// Transform to lower case
+	std::transform(string.begin(), string.end(), string.begin(), tolower);
+	if (string == "linear")
+	{
+		return DriftType::Linear;
+	}
+	else if (string == "quadratic")
+	{
+		return DriftType::Quadratic;
+	}
+	else
+	{
+		LogAndThrow<std::invalid_argument>("Unknown drift type: " + string);
+	}
+}
+
+KrigingParameters::PrecisionType KrigingParameters::StringToPrecisionType(std::string string)
+{
+	// Transform to lower case
+	std::transform(string.begin(), string.end(), string.begin(), tolower);
+	if (string == "double")
+	{
+		return PrecisionType::Double;
+	}
+	else if (string == "float")
+	{
+		return PrecisionType::Float;
+	}
+	else
+	{
+		LogAndThrow<std::invalid_argument>("Unknown grade precision: " + string);
+	}
+}
+
+KrigingParameters::SearchType KrigingParameters::StringToSearchType(std::string string)
+{
+	// Transform to lower case
+	std::transform(string.begin(), string.end(), string.begin(), tolower);
+	if (string == "perblock")
+	{
+		return SearchType::PerBlock;
+	}
+	else if (string == "tiled")
+	{
+		return SearchType::Tiled;
+	}
+	else
+	{
+		LogAndThrow<std::invalid_argument>("Unknown search mode: " + string);
+	}
+}
+
+KrigingParameters::CovarianceTableType KrigingParameters::StringToCovarianceTableType(std::string string)
+{
+	// Transform to lower case
+	std::transform(string.begin(), string.end(), string.begin(), tolower);
+	if (string == "none")
+	{
+		return CovarianceTableType::None;
+	}
+	else if (string == "linear")
+	{
+		return CovarianceTableType::Linear;
+	}
+	else if (string == "cubic")
+	{
+		return CovarianceTableType::Cubic;
+	}
+	else
+	{
+		LogAndThrow<std::invalid_argument>("Unknown covariance table type: " + string);
+	}
 }
\ No newline at end of file
@@ -3,9 +3,14 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <sstream>
+#include <vector>
 #include <limits>
+#include <algorithm>
+#include <functional>
 
 #include "CoordinateExtents.hpp"
+#include "Anisotropy.hpp"
 #include "include\json.hpp"
 #include "Helpers.hpp"
 
@@ -13,7 +18,14 @@
 /**
  * @brief Parameters to define the variogram fit
  *
- * Simplifications: Single structure, isotropic, global variogram
+ * Anisotropy is defined by the major range (Range), semi-major and minor ranges, and the GSLIB azimuth, dip and
+ * plunge angles of the major axis, in degrees.
+ *
+ * A nugget plus several nested structures, each with its own type, sill contribution and anisotropy, are defined
+ * by NestedStructures. The single structure fields then mirror the first nested structure, and the sill is the
+ * nugget plus the sum of the contributions.
+ *
+ * Simplifications: Global variogram
  */
 class VariogramParameters
 {
@@ -27,8 +39,35 @@ public:
 
 	double Nugget;
 	double Sill;
-	double Range;
+	double Range; // Range along the major axis
 	StructureType Structure;
+	double RangeSemiMajor = 0.0; // Range along the semi-major axis; 0 uses Range
+	double RangeMinor = 0.0; // Range along the minor axis; 0 uses Range
+	double Azimuth = 0.0; // Azimuth of the major axis, degrees clockwise from north
+	double Dip = 0.0; // Dip of the major axis, degrees below horizontal
+	double Plunge = 0.0; // Rotation about the major axis, degrees
+
+	/**
+	 * @brief One nested variogram structure
+	 */
+	struct NestedStructure
+	{
+		StructureType Structure;
+		double Contribution; // Sill contribution of the structure
+		double Range; // Range along the major axis
+		double RangeSemiMajor = 0.0; // Range along the semi-major axis; 0 uses Range
+		double RangeMinor = 0.0; // Range along the minor axis; 0 uses Range
+		double Azimuth = 0.0; // Azimuth of the major axis, degrees clockwise from north
+		double Dip = 0.0; // Dip of the major axis, degrees below horizontal
+		double Plunge = 0.0; // Rotation about the major axis, degrees
+	};
+
+	std::vector<NestedStructure> NestedStructures; // Nested structures; empty uses the single structure above
+
+	/**
+	 * @brief Returns the nested structures, or the single structure with contribution Sill - Nugget if there are none
+	 */
+	std::vector<NestedStructure> GetStructures() const;
 
 	/**
 	 * @brief Returns StructureType corresponding to input string
@@ -36,6 +75,33 @@ public:
 	static StructureType StringToStructureType(std::string structure);
 };
 
+/**
+ * @brief Parameters to define an anisotropic search ellipsoid
+ *
+ * The major axis range is the maximum search radius. Angles follow the same GSLIB convention as the variogram.
+ */
+struct SearchEllipsoidParameters
+{
+	double RangeSemiMajor = 0.0; // Search range along the semi-major axis; 0 uses the maximum search radius
+	double RangeMinor = 0.0; // Search range along the minor axis; 0 uses the maximum search radius
+	double Azimuth = 0.0; // Azimuth of the major axis, degrees clockwise from north
+	double Dip = 0.0; // Dip of the major axis, degrees below horizontal
+	double Plunge = 0.0; // Rotation about the major axis, degrees
+};
+
+/**
+ * @brief Parameters to discretize blocks for block kriging
+ *
+ * Each block is represented by the centres of CountI x CountJ x CountK equal sub-blocks. The default single point
+ * is point kriging at the block centroid.
+ */
+struct BlockDiscretizationParameters
+{
+	int CountI = 1; // Number of discretization points along X
+	int CountJ = 1; // Number of discretization points along Y
+	int CountK = 1; // Number of discretization points along Z
+};
+
 /**
  * @brief Parameters to define a regular block model
  *
@@ -50,24 +116,75 @@ struct BlockModelInfo
 /**
  * @brief Parameters required to run the kriging engine
  *
- * Simplifications: No quadrant/octant search, isotropic, one type of kriging, and much more.
+ * Simplifications: No quadrant/octant search, no external drift or cokriging, and much more.
  */
 class KrigingParameters
 {
 public:
 	enum KrigingType
 	{
-		Ordinary = 0 // Default
+		Ordinary = 0, // Default; unknown local mean, weights constrained to sum to one
+		Simple = 1, // Known global mean per variable; unconstrained weights on the residuals from the mean
+		Universal = 2, // Unknown local mean with a polynomial drift in X, Y and Z; weights reproduce the drift terms
+		Indicator = 3 // Ordinary kriging of the indicators of each cutoff with one (median indicator) variogram; estimates a CCDF per block
 		// TODO: Support other types of kriging
 	};
 
+	enum SolverType
+	{
+		Cholesky = 0, // Default; Cholesky of the covariance block plus Schur complement for the Lagrange row, QR fallback if ill-conditioned
+		QR = 1 // Column pivoting Householder QR of the full kriging system
+	};
+
+	enum SearchType
+	{
+		PerBlock = 0, // Default; one kd-tree nearest neighbour search per block
+		Tiled = 1 // One kd-tree radius search per tile of blocks, then per-block selection from the tile's candidates
+	};
+
+	enum CovarianceTableType
+	{
+		None = 0, // Default; covariances are evaluated directly
+		Linear = 1, // Linear interpolation of tabulated exponential and gaussian structures
+		Cubic = 2 // Cubic (Catmull-Rom) interpolation of tabulated exponential and gaussian structures
+	};
+
+	enum class DriftType
+	{
+		Linear = 0, // Default; drift terms 1, x, y, z
+		Quadratic = 1 // Drift terms 1, x, y, z, x^2, y^2, z^2, xy, xz, yz
+	};
+
+	enum PrecisionType
+	{
+		Double = 0, // Default; 64-bit block grades
+		Float = 1 // 32-bit block grades; ~7 significant digits at half the memory
+	};
+
 	// Optional properties
-	KrigingType Type; // Type of kriging, not used yet, default ordinary kriging
+	KrigingType Type; // Type of kriging, default ordinary kriging
 	int MinNumComposites; // Minimum number of composites per block, default 1
 	int MaxNumComposites; // Maximum number of composites per block, default 15
+	SolverType Solver = SolverType::Cholesky; // Kriging system solver, default Cholesky
+	int NumThreads = 0; // Number of worker threads, default 0 uses all hardware threads
+	std::vector<std::string> Variables = { "Grade" }; // Composite value columns to estimate with shared kriging weights, default Grade
+	std::vector<double> GlobalMeans; // Simple kriging mean per variable, default empty uses the composite means
+	DriftType Drift = DriftType::Linear; // Universal kriging drift, default linear
+	std::vector<double> Cutoffs; // Indicator kriging grade cutoffs in increasing order, default empty
+	bool OutputDiagnostics = false; // Output kriging variance, slope of regression and neighbourhood statistics per block, default false
+	bool CrossValidation = false; // Re-estimate every composite from its neighbours, excluding itself, instead of kriging blocks, default false
+	bool CacheComposites = false; // Cache imported composites in a binary file next to the CSV for faster reloads, default false
+	PrecisionType GradePrecision = PrecisionType::Double; // Storage precision of block grades, default double
+	SearchType SearchMode = SearchType::PerBlock; // Composite search mode, default per block
+	int TileSize = 4; // Number of blocks along each edge of a search tile, default 4
+	int KdTreeLeafSize = 10; // Maximum number of composites per kd-tree leaf, default 10
+	SearchEllipsoidParameters SearchEllipsoid; // Search ellipsoid with MaxRadius as its major range, default spherical
+	CovarianceTableType CovarianceTable = CovarianceTableType::None; // Covariance table interpolation, default none
+	int CovarianceTableResolution = 512; // Covariance table entries per structure range, default 512
+	BlockDiscretizationParameters BlockDiscretization; // Discretization points per block, default 1x1x1 (point kriging at the centroid)
 
 	//Required properties
-	double MaxRadius; // Maximum isotropic search radius, default unlimited
+	double MaxRadius; // Maximum search radius; the major range of the search ellipsoid
 	VariogramParameters VariogramParameters; // Variogram parameters
 	BlockModelInfo BlockParameters; // Block model definition
 
@@ -76,11 +193,49 @@ public:
 	 */
 	void SerializeParameters(const std::string& filePath);
 
+	/**
+	 * @brief Returns the transform that turns the search ellipsoid into a sphere of radius MaxRadius
+	 */
+	Anisotropy GetSearchAnisotropy() const;
+
+	/**
+	 * @brief Returns the longest axis of the search ellipsoid, which bounds the search in model coordinates
+	 */
+	double GetMaxSearchRange() const;
+
+	/**
+	 * @brief Returns the names of the estimated block columns: the variables, or for indicator kriging the
+	 * probability that the variable is at most each cutoff, e.g. "Grade<=0.5"
+	 */
+	std::vector<std::string> GetEstimateNames() const;
+
+	/**
+	 * @brief Returns the number of drift terms of the drift type, including the constant term
+	 */
+	static size_t GetNumDriftTerms(DriftType drift) { return drift == DriftType::Quadratic ? 10 : 4; }
+
 private:
 	// Optional property defaults
 	const KrigingType mDefaultType = KrigingType::Ordinary;
 	const int mDefaultMinNumComposites = 1;
 	const int mDefaultMaxNumComposites = 15;
+	const SolverType mDefaultSolver = SolverType::Cholesky;
+	const int mDefaultNumThreads = 0;
+	const std::vector<std::string> mDefaultVariables = { "Grade" };
+	const std::vector<double> mDefaultGlobalMeans = {};
+	const DriftType mDefaultDrift = DriftType::Linear;
+	const std::vector<double> mDefaultCutoffs = {};
+	const bool mDefaultOutputDiagnostics = false;
+	const bool mDefaultCrossValidation = false;
+	const bool mDefaultCacheComposites = false;
+	const PrecisionType mDefaultGradePrecision = PrecisionType::Double;
+	const SearchType mDefaultSearchMode = SearchType::PerBlock;
+	const int mDefaultTileSize = 4;
+	const int mDefaultKdTreeLeafSize = 10;
+	const SearchEllipsoidParameters mDefaultSearchEllipsoid = SearchEllipsoidParameters();
+	const CovarianceTableType mDefaultCovarianceTable = CovarianceTableType::None;
+	const int mDefaultCovarianceTableResolution = 512;
+	const BlockDiscretizationParameters mDefaultBlockDiscretization = BlockDiscretizationParameters();
 
 	//Minimum non-zero double value for validation
 	const double mDoubleValMin = 0.00001;
@@ -109,4 +264,29 @@ private:
 	 * @brief Returns KrigingType corresponding to input string
 	 */
 	static KrigingType StringToKrigingType(std::string string);
+
+	/**
+	 * @brief Returns SolverType corresponding to input string
+	 */
+	static SolverType StringToSolverType(std::string string);
+
+	/**
+	 * @brief Returns PrecisionType corresponding to input string
+	 */
+	static PrecisionType StringToPrecisionType(std::string string);
+
+	/**
+	 * @brief Returns SearchType corresponding to input string
+	 */
+	static SearchType StringToSearchType(std::string string);
+
+	/**
+	 * @brief Returns DriftType corresponding to input string
+	 */
+	static DriftType StringToDriftType(std::string string);
+
+	/**
+	 * @brief Returns CovarianceTableType corresponding to input string
+	 */
+	static CovarianceTableType StringToCovarianceTableType(std::string string);
 };
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "include/Eigen/Dense"
+#include "KrigingParameters.hpp"
+
+/**
+ * @brief Storage and solver for an ordinary, simple or universal kriging system with a compile-time maximum
+ * neighbourhood size.
+ *
+ * The system is the sample covariance matrix K bordered by constraint columns F: none for simple kriging, a
+ * column of ones for ordinary kriging, and the drift terms for universal kriging.
+ *
+ * For a fixed MaxN, all matrices and factorizations are stack allocated with a runtime active size of up to
+ * MaxN + MaxNumConstraints, so building and solving a system performs no heap allocations. Use Eigen::Dynamic
+ * for neighbourhoods larger than the largest fixed kernel.
+ *
+ * @tparam MaxN Maximum number of composites in the neighbourhood, or Eigen::Dynamic.
+ */
+template <int MaxN>
+class KrigingSystem
+{
+public:
+	// Largest number of constraint rows, the terms of a quadratic drift (see DriftFunctions)
+	static constexpr int MaxNumConstraints = 10;
+
+	static constexpr int MaxSize = (MaxN == Eigen::Dynamic) ? Eigen::Dynamic : MaxN + MaxNumConstraints;
+
+	using Matrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor, MaxSize, MaxSize>;
+	using Vector = Eigen::Matrix<double, Eigen::Dynamic, 1, Eigen::ColMajor, MaxSize, 1>;
+
+	Matrix C; // LHS Covariance matrix cij between sample locations i,j, bordered by the constraint rows and columns
+	Vector D; // RHS Covariance vector ci0 between sample locations i and estimation point 0, then the constraint values
+	Vector Weights; // Kriging weights, then the Lagrange multipliers of the constraints
+	Vector PointCovariances; // Covariances between one block discretization point and each sample; scratch for block kriging
+
+	/**
+	 * @brief Sets the active size and type of the system for n samples.
+	 *
+	 * Ordinary kriging systems have one Lagrange row and column, universal kriging systems one per drift term,
+	 * and simple kriging systems are the n x n covariances only.
+	 *
+	 * @param numDriftTerms Number of drift terms, including the constant term; universal kriging only.
+	 */
+	void Resize(Eigen::Index n, KrigingParameters::KrigingType type = KrigingParameters::KrigingType::Ordinary,
+		Eigen::Index numDriftTerms = 0)
+	{
+		mType = type;
+		mNumConstraints = type == KrigingParameters::KrigingType::Simple ? 0
+			: type == KrigingParameters::KrigingType::Universal ? numDriftTerms : 1;
+		Eigen::Index size = n + mNumConstraints;
+		C.resize(size, size);
+		D.resize(size);
+		Weights.resize(size);
+		PointCovariances.resize(n);
+	}
+
+	/**
+	 * @brief Solves C * Weights = D.
+	 *
+	 * The covariance block of C is symmetric, so the Cholesky solver factorizes it once and eliminates the
+	 * Lagrange row with a Schur complement. Falls back to QR of the full system if the covariance block is
+	 * not positive definite or is ill-conditioned (e.g. duplicate sample locations).
+	 *
+	 * A simple kriging system is the symmetric covariance matrix alone, so the Cholesky solver solves it directly.
+	 * Universal kriging eliminates all drift constraints at once, reusing the factorization of K.
+	 */
+	void Solve(KrigingParameters::SolverType solver)
+	{
+		if (mType == KrigingParameters::KrigingType::Simple)
+		{
+			SolveSimple(solver);
+			return;
+		}
+		if (mType == KrigingParameters::KrigingType::Universal)
+		{
+			SolveUniversal(solver);
+			return;
+		}
+
+		Eigen::Index n = D.size() - 1;
+
+		if (solver == KrigingParameters::SolverType::Cholesky && n > 0)
+		{
+			// Factorize the symmetric covariance block K only
+			mLlt.compute(C.topLeftCorner(n, n));
+
+			if (mLlt.info() == Eigen::Success && mLlt.rcond() > mMinCholeskyRCond)
+			{
+				// Schur complement for the unbiasedness constraint:
+				// K * a = D0, K * b = 1, mu = (sum(a) - 1) / sum(b), weights = a - mu * b
+				mA = D.head(n);
+				mLlt.solveInPlace(mA);
+				mB.setOnes(n);
+				mLlt.solveInPlace(mB);
+				double mu = (mA.sum() - D(n)) / mB.sum();
+
+				Weights.head(n) = mA - mu * mB;
+				Weights(n) = mu;
+				return;
+			}
+			// Otherwise fall through to QR
+		}
+
+		mQr.compute(C);
+		Weights = mQr.solve(D);
+	}
+
+	/**
+	 * @brief Get number of constraint rows bordering the covariance matrix
+	 */
+	Eigen::Index GetNumConstraints() const { return mNumConstraints; }
+
+private:
+	using DriftMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor, MaxN, MaxNumConstraints>;
+	using ConstraintMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor, MaxNumConstraints, MaxNumConstraints>;
+	using ConstraintVector = Eigen::Matrix<double, Eigen::Dynamic, 1, Eigen::ColMajor, MaxNumConstraints, 1>;
+
+	KrigingParameters::KrigingType mType = KrigingParameters::KrigingType::Ordinary;
+	Eigen::Index mNumConstraints = 1;
+
+	// Reciprocal condition number below which the Cholesky factorization is considered ill-conditioned
+	static constexpr double mMinCholeskyRCond = 1e-12;
+
+	Eigen::LLT<Matrix> mLlt;
+	Eigen::ColPivHouseholderQR<Matrix> mQr;
+	Vector mA, mB; // Schur complement intermediate solutions
+	DriftMatrix mDriftSolution; // K^-1 * F for universal kriging
+	ConstraintMatrix mSchur; // Schur complement F' * K^-1 * F for universal kriging
+	Eigen::LLT<ConstraintMatrix> mSchurLlt;
+	ConstraintVector mMu; // Lagrange multipliers of the drift constraints
+
+	/**
+	 * @brief Solves the simple kriging system C * Weights = D, with the same QR fallback as ordinary kriging.
+	 */
+	void SolveSimple(KrigingParameters::SolverType solver)
+	{
+		if (solver == KrigingParameters::SolverType::Cholesky && D.size() > 0)
+		{
+			mLlt.compute(C);
+			if (mLlt.info() == Eigen::Success && mLlt.rcond() > mMinCholeskyRCond)
+			{
+				Weights = D;
+				mLlt.solveInPlace(Weights);
+				return;
+			}
+		}
+
+		mQr.compute(C);
+		Weights = mQr.solve(D);
+	}
+
+	/**
+	 * @brief Solves the universal kriging system, with the same QR fallback as ordinary kriging.
+	 *
+	 * Falls back to QR also if the drift terms are nearly collinear at the sample locations (e.g. all samples
+	 * in one horizontal plane), as the Schur complement is then singular.
+	 */
+	void SolveUniversal(KrigingParameters::SolverType solver)
+	{
+		Eigen::Index p = mNumConstraints;
+		Eigen::Index n = D.size() - p;
+
+		if (solver == KrigingParameters::SolverType::Cholesky && n > 0)
+		{
+			mLlt.compute(C.topLeftCorner(n, n));
+			if (mLlt.info() == Eigen::Success && mLlt.rcond() > mMinCholeskyRCond)
+			{
+				// Block elimination of the drift constraints, reusing the factorization of K:
+				// K * a = D0, K * B = F, (F' * B) * mu = F' * a - f0, weights = a - B * mu
+				auto F = C.topRightCorner(n, p);
+				mA = D.head(n);
+				mLlt.solveInPlace(mA);
+				mDriftSolution = F;
+				mLlt.solveInPlace(mDriftSolution);
+				mSchur.noalias() = F.transpose() * mDriftSolution;
+				mSchurLlt.compute(mSchur);
+
+				if (mSchurLlt.info() == Eigen::Success && mSchurLlt.rcond() > mMinCholeskyRCond)
+				{
+					mMu.noalias() = F.transpose() * mA;
+					mMu -= D.tail(p);
+					mSchurLlt.solveInPlace(mMu);
+
+					Weights.head(n) = mA;
+					Weights.head(n).noalias() -= mDriftSolution * mMu;
+					Weights.tail(p) = mMu;
+					return;
+				}
+			}
+		}
+
+		mQr.compute(C);
+		Weights = mQr.solve(D);
+	}
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include "Composites.hpp"
+#include "KrigingSystem.hpp"
+
+/**
+ * @brief Reusable per-thread buffers for kriging blocks.
+ *
+ * Each worker thread owns one workspace, which is passed through KrigeOneBlock, FindNearestComposites and
+ * OrdinaryKrigingPoint. Buffers are reserved up front for the maximum neighbourhood size, so after the first
+ * block the hot loop performs no heap allocations for fixed-size kernels. The dynamic kernel only reallocates
+ * its matrices when the neighbourhood size changes between blocks.
+ *
+ * @tparam MaxN Maximum number of composites in the neighbourhood, or Eigen::Dynamic.
+ */
+template <int MaxN>
+class KrigingWorkspace
+{
+public:
+	NearestCompositesResult Neighbours; // Nearest composite search result for the current block
+	CompositeCandidates Candidates; // Candidate composites for the current tile of blocks; tiled search only
+	std::vector<double> X, Y, Z; // Coordinates of the composites in the current neighbourhood
+	KrigingSystem<MaxN> System; // Kriging system for the current block
+	std::vector<double> Estimates; // Estimates for the current block, one per variable, or one per cutoff for indicator kriging
+	std::vector<double> DownwardCcdf; // Downward order relation correction of the current block's CCDF; indicator kriging only
+	KrigingDiagnostics Diagnostics; // Diagnostics for the current block; only filled if requested
+
+	/**
+	 * @brief Reserves buffers for neighbourhoods of up to maxNumComposites composites, and numEstimates estimates.
+	 */
+	KrigingWorkspace(int maxNumComposites, size_t numEstimates)
+		: Estimates(numEstimates), DownwardCcdf(numEstimates)
+	{
+		size_t capacity = static_cast<size_t>(maxNumComposites);
+		Neighbours.Indices.reserve(capacity);
+		Neighbours.Distances.reserve(capacity);
+		X.reserve(capacity);
+		Y.reserve(capacity);
+		Z.reserve(capacity);
+	}
+};
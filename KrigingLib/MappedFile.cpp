@@ -0,0 +1,101 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		LogAndThrow<std::runtime_error>("File does not exist or cannot be opened: " + filePath);
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		LogAndThrow<std::runtime_error>("Unable to get size of file: " + filePath);
+	}
+	mSize = static_cast<size_t>(size.QuadPart);
+
+	// Empty files cannot be mapped
+	if (mSize > 0)
+	{
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr)
+		{
+			mData = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			// The view keeps the mapping alive
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+
+	if (mSize > 0 && mData == nullptr)
+	{
+		LogAndThrow<std::runtime_error>("Unable to map file into memory: " + filePath);
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (mData != nullptr)
+	{
+		UnmapViewOfFile(mData);
+	}
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+	int file = open(filePath.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		LogAndThrow<std::runtime_error>("File does not exist or cannot be opened: " + filePath);
+	}
+
+	struct stat status;
+	if (fstat(file, &status) != 0)
+	{
+		close(file);
+		LogAndThrow<std::runtime_error>("Unable to get size of file: " + filePath);
+	}
+	mSize = static_cast<size_t>(status.st_size);
+
+	// Empty files cannot be mapped
+	if (mSize > 0)
+	{
+		void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, file, 0);
+		if (data != MAP_FAILED)
+		{
+			mData = static_cast<const char*>(data);
+			madvise(data, mSize, MADV_SEQUENTIAL);
+		}
+	}
+	// The mapping stays valid after the file is closed
+	close(file);
+
+	if (mSize > 0 && mData == nullptr)
+	{
+		LogAndThrow<std::runtime_error>("Unable to map file into memory: " + filePath);
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (mData != nullptr)
+	{
+		munmap(const_cast<char*>(mData), mSize);
+	}
+}
+
+#endif
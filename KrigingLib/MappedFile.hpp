@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <stdexcept>
+
+#include "Helpers.hpp"
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * The file contents are accessed in place through the operating system's page cache, without copying into
+ * user buffers. The mapping is released when the object is destroyed.
+ */
+class MappedFile
+{
+public:
+	/**
+	 * @brief Maps the file at filePath into memory; throws std::runtime_error if it cannot be opened or mapped.
+	 */
+	explicit MappedFile(const std::string& filePath);
+
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/**
+	 * @brief Get pointer to the first byte of the file; nullptr for an empty file
+	 */
+	const char* GetData() const { return mData; }
+
+	/**
+	 * @brief Get size of the file in bytes
+	 */
+	size_t GetSize() const { return mSize; }
+
+private:
+	const char* mData = nullptr;
+	size_t mSize = 0;
+};
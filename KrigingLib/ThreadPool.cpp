@@ -0,0 +1,187 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(size_t numThreads)
+{
+	if (numThreads == 0)
+	{
+		numThreads = std::thread::hardware_concurrency();
+		if (numThreads == 0)
+		{
+			size_t defaultNumThread = 8;
+			std::cerr << "Unable to determine the number of threads. Using default number of threads: " << defaultNumThread << std::endl;
+			numThreads = defaultNumThread;
+		}
+	}
+
+	mQueues = std::vector<ChunkQueue>(numThreads);
+	mThreads.reserve(numThreads);
+	for (size_t i = 0; i < numThreads; ++i)
+	{
+		mThreads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mWorkAvailable.notify_all();
+
+	for (auto& thread : mThreads)
+	{
+		thread.join();
+	}
+}
+
+std::vector<ThreadStatistics> ThreadPool::ParallelFor(size_t count, size_t chunkSize,
+	const std::function<void(size_t, size_t, size_t)>& func)
+{
+	size_t numThreads = mThreads.size();
+	if (count == 0)
+	{
+		return std::vector<ThreadStatistics>(numThreads);
+	}
+
+	chunkSize = std::max<size_t>(chunkSize, 1);
+	size_t numChunks = (count + chunkSize - 1) / chunkSize;
+
+	// Distribute chunks evenly as contiguous ranges; neighbouring items stay on the same thread unless stolen
+	for (size_t i = 0; i < numThreads; ++i)
+	{
+		std::lock_guard<std::mutex> lock(mQueues[i].Mutex);
+		mQueues[i].Front = numChunks * i / numThreads;
+		mQueues[i].Back = numChunks * (i + 1) / numThreads;
+	}
+
+	// Publish the job and wake the workers
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mJob = &func;
+		mCount = count;
+		mChunkSize = chunkSize;
+		mStatistics.assign(numThreads, ThreadStatistics());
+		mException = nullptr;
+		mActiveWorkers = numThreads;
+		++mGeneration;
+	}
+	mWorkAvailable.notify_all();
+
+	// Wait for all workers to finish
+	std::unique_lock<std::mutex> lock(mMutex);
+	mWorkDone.wait(lock, [this] { return mActiveWorkers == 0; });
+	mJob = nullptr;
+
+	if (mException)
+	{
+		std::rethrow_exception(mException);
+	}
+
+	return mStatistics;
+}
+
+void ThreadPool::PrintStatistics(const std::vector<ThreadStatistics>& statistics, const std::string& itemName)
+{
+	for (size_t i = 0; i < statistics.size(); ++i)
+	{
+		const auto& stats = statistics[i];
+		std::cout << "Thread " << i << ": " << stats.ItemsProcessed << " " << itemName << ", "
+			<< stats.ChunksProcessed << " chunks (" << stats.ChunksStolen << " stolen), busy "
+			<< static_cast<long long>(stats.BusySeconds * 1000) << " ms" << std::endl;
+	}
+}
+
+void ThreadPool::WorkerLoop(size_t threadIndex)
+{
+	size_t seenGeneration = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWorkAvailable.wait(lock, [this, seenGeneration] { return mStop || mGeneration != seenGeneration; });
+			if (mStop)
+			{
+				return;
+			}
+			seenGeneration = mGeneration;
+		}
+
+		RunChunks(threadIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (--mActiveWorkers == 0)
+			{
+				mWorkDone.notify_one();
+			}
+		}
+	}
+}
+
+void ThreadPool::RunChunks(size_t threadIndex)
+{
+	// Accumulate locally to avoid false sharing between threads
+	ThreadStatistics stats;
+
+	size_t chunk;
+	bool stolen;
+	while (TryGetChunk(threadIndex, chunk, stolen))
+	{
+		size_t begin = chunk * mChunkSize;
+		size_t end = std::min(begin + mChunkSize, mCount);
+
+		auto startTime = std::chrono::steady_clock::now();
+		try
+		{
+			(*mJob)(begin, end, threadIndex);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (!mException)
+			{
+				mException = std::current_exception();
+			}
+		}
+		auto endTime = std::chrono::steady_clock::now();
+
+		stats.ItemsProcessed += end - begin;
+		stats.ChunksProcessed++;
+		stats.ChunksStolen += stolen ? 1 : 0;
+		stats.BusySeconds += std::chrono::duration<double>(endTime - startTime).count();
+	}
+
+	mStatistics[threadIndex] = stats;
+}
+
+bool ThreadPool::TryGetChunk(size_t threadIndex, size_t& chunk, bool& stolen)
+{
+	// Take from the front of the thread's own queue
+	{
+		auto& queue = mQueues[threadIndex];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (queue.Front < queue.Back)
+		{
+			chunk = queue.Front++;
+			stolen = false;
+			return true;
+		}
+	}
+
+	// Steal from the back of another thread's queue
+	size_t numThreads = mQueues.size();
+	for (size_t offset = 1; offset < numThreads; ++offset)
+	{
+		auto& queue = mQueues[(threadIndex + offset) % numThreads];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (queue.Front < queue.Back)
+		{
+			chunk = --queue.Back;
+			stolen = true;
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <string>
+
+/**
+ * @brief Work statistics for one worker thread over one parallel run.
+ */
+struct ThreadStatistics
+{
+	size_t ItemsProcessed = 0; // Number of items (e.g. blocks) processed
+	size_t ChunksProcessed = 0; // Number of chunks processed, including stolen chunks
+	size_t ChunksStolen = 0; // Number of chunks taken from other threads' queues
+	double BusySeconds = 0.0; // Time spent processing chunks
+};
+
+/**
+ * @brief Persistent pool of worker threads with work stealing.
+ *
+ * Work is split into small chunks, distributed evenly as contiguous ranges across per-thread queues.
+ * Threads take chunks from the front of their own queue, and once it is empty steal from the back of other
+ * threads' queues, so a run finishes when the total work is done rather than when the slowest range finishes.
+ * Threads are created once and reused across calls to ParallelFor.
+ */
+class ThreadPool
+{
+public:
+	/**
+	 * @brief Starts the worker threads.
+	 *
+	 * @param numThreads Number of worker threads; 0 uses the system hardware concurrency (default 8 if unknown).
+	 */
+	explicit ThreadPool(size_t numThreads = 0);
+
+	/**
+	 * @brief Stops and joins the worker threads.
+	 */
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * @brief Get number of worker threads
+	 */
+	size_t GetNumThreads() const { return mThreads.size(); }
+
+	/**
+	 * @brief Runs func over the item range [0, count) in chunks, and waits for completion.
+	 *
+	 * Must not be called concurrently from multiple threads. The first exception thrown by func is rethrown
+	 * once all chunks have finished.
+	 *
+	 * @param count Number of items.
+	 * @param chunkSize Number of items per chunk.
+	 * @param func Function called as func(begin, end, threadIndex) for each chunk [begin, end); threadIndex is
+	 * in [0, GetNumThreads()) and can be used to index per-thread state.
+	 * @return Statistics per worker thread.
+	 */
+	std::vector<ThreadStatistics> ParallelFor(size_t count, size_t chunkSize,
+		const std::function<void(size_t, size_t, size_t)>& func);
+
+	/**
+	 * @brief Writes a per-thread summary of statistics to the console.
+	 *
+	 * @param itemName Plural name of the processed items, e.g. "blocks".
+	 */
+	static void PrintStatistics(const std::vector<ThreadStatistics>& statistics, const std::string& itemName);
+
+private:
+	/**
+	 * @brief Queue of chunk indices [Front, Back) owned by one thread.
+	 */
+	struct ChunkQueue
+	{
+		std::mutex Mutex;
+		size_t Front = 0;
+		size_t Back = 0;
+	};
+
+	std::vector<std::thread> mThreads;
+	std::vector<ChunkQueue> mQueues;
+
+	// Job state; guarded by mMutex
+	std::mutex mMutex;
+	std::condition_variable mWorkAvailable;
+	std::condition_variable mWorkDone;
+	size_t mGeneration = 0; // Incremented for each job so workers wake once per job
+	size_t mActiveWorkers = 0;
+	bool mStop = false;
+	std::exception_ptr mException;
+
+	// Current job; set before workers are woken and unchanged until they finish
+	const std::function<void(size_t, size_t, size_t)>* mJob = nullptr;
+	size_t mCount = 0;
+	size_t mChunkSize = 1;
+	std::vector<ThreadStatistics> mStatistics;
+
+	/**
+	 * @brief Main loop of each worker thread; waits for jobs and processes chunks.
+	 */
+	void WorkerLoop(size_t threadIndex);
+
+	/**
+	 * @brief Processes chunks until all queues are empty.
+	 */
+	void RunChunks(size_t threadIndex);
+
+	/**
+	 * @brief Gets the next chunk from the thread's own queue, or steals one from another thread.
+	 *
+	 * @return False if no chunks remain in any queue.
+	 */
+	bool TryGetChunk(size_t threadIndex, size_t& chunk, bool& stolen);
+};
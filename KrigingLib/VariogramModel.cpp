@@ -0,0 +1,144 @@
+#include "VariogramModel.hpp"
+
+VariogramModel::VariogramModel(const VariogramParameters& parameters, KrigingParameters::CovarianceTableType table,
+	int tableResolution)
+	: mNugget(parameters.Nugget), mSill(parameters.Sill)
+{
+	auto structures = parameters.GetStructures();
+
+	// The first structure defines the isotropic space of the coordinates
+	const auto& first = structures.front();
+	mAnisotropy = Anisotropy(first.Range, first.RangeSemiMajor, first.RangeMinor, first.Azimuth, first.Dip, first.Plunge);
+
+	mStructures.reserve(structures.size());
+	for (const auto& structure : structures)
+	{
+		Anisotropy anisotropy(structure.Range, structure.RangeSemiMajor, structure.RangeMinor, structure.Azimuth, structure.Dip,
+			structure.Plunge);
+
+		CompiledStructure compiled;
+		ResolveShape(structure.Structure, compiled);
+		compiled.Contribution = structure.Contribution;
+		compiled.Range = structure.Range;
+		compiled.Transform = anisotropy.RelativeTo(mAnisotropy);
+
+		// Spherical structures are cheaper to evaluate than to interpolate
+		if (table != KrigingParameters::CovarianceTableType::None && structure.Structure != VariogramParameters::Spherical)
+		{
+			mMaxSampledTableError += compiled.Contribution * BuildTable(compiled, table, tableResolution);
+		}
+		mIsDistanceOnly = mIsDistanceOnly && compiled.Transform.IsIsotropic();
+		mStructures.push_back(std::move(compiled));
+	}
+}
+
+void VariogramModel::Covariances(double* values, size_t count) const
+{
+	// Variograms are accumulated per batch, so each lag can be overwritten by its covariance
+	double gamma[mBatchSize];
+	for (size_t begin = 0; begin < count; begin += mBatchSize)
+	{
+		size_t size = std::min(mBatchSize, count - begin);
+		double* h = values + begin;
+		std::fill_n(gamma, size, mNugget);
+		for (const auto& structure : mStructures)
+		{
+			structure.Accumulate(structure, h, gamma, size);
+		}
+		for (size_t i = 0; i < size; ++i)
+		{
+			h[i] = mSill - gamma[i];
+		}
+	}
+}
+
+template <>
+double VariogramModel::Shape<VariogramParameters::Spherical>(double ha)
+{
+	if (ha > 1.0)
+	{
+		return 1.0;
+	}
+	return 1.5 * ha - 0.5 * ha * ha * ha;
+}
+
+template <>
+double VariogramModel::Shape<VariogramParameters::Exponential>(double ha)
+{
+	return 1 - exp(-3 * ha);
+}
+
+template <>
+double VariogramModel::Shape<VariogramParameters::Gaussian>(double ha)
+{
+	return 1 - exp(-3 * ha * ha);
+}
+
+void VariogramModel::ResolveShape(VariogramParameters::StructureType structure, CompiledStructure& compiled)
+{
+	switch (structure)
+	{
+	case VariogramParameters::Spherical:
+		compiled.ExactShape = &Shape<VariogramParameters::Spherical>;
+		compiled.Shape = &ExactShape<VariogramParameters::Spherical>;
+		compiled.Accumulate = &AccumulateShape<&ExactShape<VariogramParameters::Spherical>>;
+		break;
+	case VariogramParameters::Exponential:
+		compiled.ExactShape = &Shape<VariogramParameters::Exponential>;
+		compiled.Shape = &ExactShape<VariogramParameters::Exponential>;
+		compiled.Accumulate = &AccumulateShape<&ExactShape<VariogramParameters::Exponential>>;
+		break;
+	case VariogramParameters::Gaussian:
+		compiled.ExactShape = &Shape<VariogramParameters::Gaussian>;
+		compiled.Shape = &ExactShape<VariogramParameters::Gaussian>;
+		compiled.Accumulate = &AccumulateShape<&ExactShape<VariogramParameters::Gaussian>>;
+		break;
+	default:
+		LogAndThrow<std::invalid_argument>("Unsupported variogram model");
+	}
+}
+
+double VariogramModel::BuildTable(CompiledStructure& structure, KrigingParameters::CovarianceTableType table, int tableResolution)
+{
+	double resolution = static_cast<double>(tableResolution);
+
+	// Tabulate until the shape is within tolerance of its sill
+	size_t maxIntervals = static_cast<size_t>(mMaxTableDistance * resolution);
+	size_t numIntervals = 1;
+	while (numIntervals < maxIntervals && 1.0 - structure.ExactShape(numIntervals / resolution) > mTableTailTolerance)
+	{
+		++numIntervals;
+	}
+
+	// Entries from t = -1 to t = numIntervals + 1, so cubic interpolation has neighbours on both sides of every
+	// interval; the shapes are analytic, so the entry at t = -1 is their smooth continuation
+	structure.Table.resize(numIntervals + 3);
+	for (size_t k = 0; k < structure.Table.size(); ++k)
+	{
+		structure.Table[k] = structure.ExactShape((static_cast<double>(k) - 1.0) / resolution);
+	}
+	structure.TableResolution = resolution;
+	structure.TableLimit = static_cast<double>(numIntervals);
+	if (table == KrigingParameters::CovarianceTableType::Linear)
+	{
+		structure.Shape = &TableShape<KrigingParameters::CovarianceTableType::Linear>;
+		structure.Accumulate = &AccumulateShape<&TableShape<KrigingParameters::CovarianceTableType::Linear>>;
+	}
+	else
+	{
+		structure.Shape = &TableShape<KrigingParameters::CovarianceTableType::Cubic>;
+		structure.Accumulate = &AccumulateShape<&TableShape<KrigingParameters::CovarianceTableType::Cubic>>;
+	}
+
+	// Sample the interpolation error at evenly spaced lags within every interval
+	double maxError = 0.0;
+	for (size_t k = 0; k < numIntervals; ++k)
+	{
+		for (int sample = 1; sample <= mTableErrorSamples; ++sample)
+		{
+			double ha = (k + static_cast<double>(sample) / (mTableErrorSamples + 1)) / resolution;
+			maxError = std::max(maxError, std::abs(structure.Shape(structure, ha) - structure.ExactShape(ha)));
+		}
+	}
+	return maxError;
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "Anisotropy.hpp"
+#include "KrigingParameters.hpp"
+
+/**
+ * @brief Variogram compiled once per run for fast evaluation in kriging systems.
+ *
+ * The structure type of each nested structure is resolved to its shape function once, on construction, so
+ * evaluations loop over a short list of function pointers instead of switching on the structure type for every
+ * pair of samples.
+ *
+ * Coordinates and lags are in the isotropic space of the first structure (see GetAnisotropy). Each further
+ * structure keeps its anisotropy relative to that space; structures sharing the first structure's angles and
+ * range ratios need no transform, and if all do, covariances depend only on the lag distance (IsDistanceOnly).
+ *
+ * Optionally, exponential and gaussian structures are tabulated over normalized distance (lag over range) and
+ * interpolated, replacing an exp call per evaluation with a table lookup. Tables extend until the structure
+ * reaches its sill within mTableTailTolerance; longer lags are evaluated directly.
+ */
+class VariogramModel
+{
+public:
+	/**
+	 * @param table Interpolation of tabulated exponential and gaussian structures; None evaluates them directly.
+	 * @param tableResolution Number of table entries per structure range.
+	 */
+	explicit VariogramModel(const VariogramParameters& parameters,
+		KrigingParameters::CovarianceTableType table = KrigingParameters::CovarianceTableType::None, int tableResolution = 512);
+
+	/**
+	 * @brief Get transform from model coordinates into the isotropic space of the first structure
+	 */
+	const Anisotropy& GetAnisotropy() const { return mAnisotropy; }
+
+	/**
+	 * @brief True if covariances depend only on the lag distance in the first structure's isotropic space
+	 */
+	bool IsDistanceOnly() const { return mIsDistanceOnly; }
+
+	/**
+	 * @brief Get variogram sill, the nugget plus all structure contributions
+	 */
+	double GetSill() const { return mSill; }
+
+	/**
+	 * @brief Get nugget, the variogram at lags just above zero
+	 */
+	double GetNugget() const { return mNugget; }
+
+	/**
+	 * @brief Get largest absolute covariance error of the tables at the lags sampled when they were built; 0 without
+	 * tables. An estimate of the worst case rather than a bound, since the error between samples is not measured.
+	 */
+	double GetMaxSampledTableError() const { return mMaxSampledTableError; }
+
+	/**
+	 * @brief Calculates the variogram value for lag distance h along the major axis of each structure.
+	 */
+	double Variogram(double h) const
+	{
+		double gamma = mNugget;
+		for (const auto& structure : mStructures)
+		{
+			gamma += structure.Contribution * structure.Shape(structure, h / structure.Range);
+		}
+		return gamma;
+	}
+
+	/**
+	 * @brief Calculates the covariance for lag distance h along the major axis of each structure.
+	 */
+	double Covariance(double h) const
+	{
+		return mSill - Variogram(h);
+	}
+
+	/**
+	 * @brief Calculates the covariance for the lag (dx, dy, dz) in the first structure's isotropic space.
+	 */
+	double Covariance(double dx, double dy, double dz) const
+	{
+		double h = sqrt(dx * dx + dy * dy + dz * dz);
+		double gamma = mNugget;
+		for (const auto& structure : mStructures)
+		{
+			double hs = h;
+			if (!structure.Transform.IsIsotropic())
+			{
+				double tx, ty, tz;
+				structure.Transform.Transform(dx, dy, dz, tx, ty, tz);
+				hs = sqrt(tx * tx + ty * ty + tz * tz);
+			}
+			gamma += structure.Contribution * structure.Shape(structure, hs / structure.Range);
+		}
+		return mSill - gamma;
+	}
+
+	/**
+	 * @brief Replaces each of count lag distances in values by its covariance, as Covariance(h).
+	 *
+	 * Loops over structures outside the lags, so each structure's shape is inlined into a loop over the lags
+	 * rather than called through a pointer per lag.
+	 */
+	void Covariances(double* values, size_t count) const;
+
+private:
+	struct CompiledStructure;
+
+	// Normalized variogram shape of a unit sill structure, for lag distance over range ha
+	using ExactShapeFunction = double (*)(double ha);
+	using ShapeFunction = double (*)(const CompiledStructure& structure, double ha);
+
+	// Adds the structure's contribution at each of count lag distances h to gamma
+	using AccumulateFunction = void (*)(const CompiledStructure& structure, const double* h, double* gamma, size_t count);
+
+	/**
+	 * @brief Nested structure with its shape function and anisotropy resolved.
+	 */
+	struct CompiledStructure
+	{
+		ShapeFunction Shape; // Exact or tabulated shape
+		AccumulateFunction Accumulate; // Shape over many lags
+		ExactShapeFunction ExactShape;
+		double Contribution;
+		double Range;
+		Anisotropy Transform; // Transform from the first structure's isotropic space
+		std::vector<double> Table; // Shape at normalized distances (k - 1) / TableResolution; empty if not tabulated
+		double TableResolution = 0.0; // Table entries per unit normalized distance
+		double TableLimit = 0.0; // Normalized distance times resolution beyond which the shape is evaluated directly
+	};
+
+	double mNugget;
+	double mSill;
+	std::vector<CompiledStructure> mStructures;
+	Anisotropy mAnisotropy;
+	bool mIsDistanceOnly = true;
+	double mMaxSampledTableError = 0.0;
+
+	// Tables end where the shape is within this tolerance of its sill
+	static constexpr double mTableTailTolerance = 1e-12;
+
+	// Longest tabulated normalized distance
+	static constexpr double mMaxTableDistance = 16.0;
+
+	// Number of points per table interval at which the interpolation error is measured
+	static constexpr int mTableErrorSamples = 3;
+
+	// Number of lags converted per batch by Covariances
+	static constexpr size_t mBatchSize = 64;
+
+	/**
+	 * @brief Sets the exact shape functions of the structure's type; the only switch on the structure type.
+	 */
+	static void ResolveShape(VariogramParameters::StructureType structure, CompiledStructure& compiled);
+
+	/**
+	 * @brief Tabulates the structure's shape and selects the interpolating shape function.
+	 *
+	 * @return Largest absolute error of the interpolated shape at mTableErrorSamples lags within each interval.
+	 */
+	static double BuildTable(CompiledStructure& structure, KrigingParameters::CovarianceTableType table, int tableResolution);
+
+	/**
+	 * @brief Normalized variogram shape of structure type Type.
+	 */
+	template <VariogramParameters::StructureType Type>
+	static double Shape(double ha);
+
+	/**
+	 * @brief Exact shape, as a ShapeFunction.
+	 */
+	template <VariogramParameters::StructureType Type>
+	static double ExactShape(const CompiledStructure&, double ha)
+	{
+		return Shape<Type>(ha);
+	}
+
+	/**
+	 * @brief Accumulate function for the shape function StructureShape.
+	 */
+	template <ShapeFunction StructureShape>
+	static void AccumulateShape(const CompiledStructure& structure, const double* h, double* gamma, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			gamma[i] += structure.Contribution * StructureShape(structure, h[i] / structure.Range);
+		}
+	}
+
+	/**
+	 * @brief Shape interpolated from the structure's table; lags beyond the table are evaluated directly.
+	 */
+	template <KrigingParameters::CovarianceTableType Interpolation>
+	static double TableShape(const CompiledStructure& structure, double ha)
+	{
+		double t = ha * structure.TableResolution;
+		if (!(t < structure.TableLimit))
+		{
+			return structure.ExactShape(ha);
+		}
+
+		// Entry k + 1 holds the shape at t = k; entry 0 is a ghost point for cubic interpolation
+		size_t k = static_cast<size_t>(t);
+		double f = t - static_cast<double>(k);
+		const double* p = structure.Table.data() + k;
+		if constexpr (Interpolation == KrigingParameters::CovarianceTableType::Linear)
+		{
+			return p[1] + f * (p[2] - p[1]);
+		}
+		else
+		{
+			// Catmull-Rom spline through p[0..3], between p[1] and p[2]
+			return p[1] + 0.5 * f * (p[2] - p[0] + f * (2.0 * p[0] - 5.0 * p[1] + 4.0 * p[2] - p[3]
+				+ f * (3.0 * (p[1] - p[2]) + p[3] - p[0])));
+		}
+	}
+};
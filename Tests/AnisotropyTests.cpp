@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../KrigingLib/Anisotropy.hpp"
+#include "../KrigingLib/IsotropicCoordinates.hpp"
+
+/**
+ * @brief Unit tests for variogram anisotropy transforms
+ */
+namespace AnisotropyTests
+{
+	const double mMaxError = 1e-9;
+
+	static VariogramParameters InitAnisotropicParameters()
+	{
+		VariogramParameters parameters;
+		parameters.Nugget = 0.1;
+		parameters.Sill = 1.0;
+		parameters.Range = 100.0;
+		parameters.RangeSemiMajor = 50.0;
+		parameters.RangeMinor = 25.0;
+		parameters.Structure = VariogramParameters::StructureType::Spherical;
+		return parameters;
+	}
+
+	static double TransformedLength(const Anisotropy& anisotropy, double x, double y, double z)
+	{
+		double tx, ty, tz;
+		anisotropy.Transform(x, y, z, tx, ty, tz);
+		return sqrt(tx * tx + ty * ty + tz * tz);
+	}
+
+	TEST(AnisotropyTest, ScalesAxesByRangeRatios)
+	{
+		// Major axis north, semi-major east, minor vertical
+		Anisotropy anisotropy(InitAnisotropicParameters());
+		EXPECT_FALSE(anisotropy.IsIsotropic());
+
+		// Test lag distances are in major range units
+		EXPECT_NEAR(10.0, TransformedLength(anisotropy, 0.0, 10.0, 0.0), mMaxError);
+		EXPECT_NEAR(20.0, TransformedLength(anisotropy, 10.0, 0.0, 0.0), mMaxError);
+		EXPECT_NEAR(40.0, TransformedLength(anisotropy, 0.0, 0.0, 10.0), mMaxError);
+	}
+
+	TEST(AnisotropyTest, RotatesMajorAxis)
+	{
+		// Major axis east, dipping 30 degrees
+		VariogramParameters parameters = InitAnisotropicParameters();
+		parameters.Azimuth = 90.0;
+		parameters.Dip = 30.0;
+		Anisotropy anisotropy(parameters);
+
+		// Test a lag along the dipping major axis is unscaled
+		double dip = 30.0 * std::numbers::pi / 180.0;
+		EXPECT_NEAR(10.0, TransformedLength(anisotropy, 10.0 * cos(dip), 0.0, -10.0 * sin(dip)), mMaxError);
+
+		// Test a horizontal north lag is along the semi-major axis
+		EXPECT_NEAR(20.0, TransformedLength(anisotropy, 0.0, 10.0, 0.0), mMaxError);
+	}
+
+	TEST(AnisotropyTest, EqualRangesAreIsotropic)
+	{
+		VariogramParameters parameters = InitAnisotropicParameters();
+		parameters.RangeSemiMajor = 0.0;
+		parameters.RangeMinor = 100.0;
+		parameters.Azimuth = 35.0;
+		parameters.Dip = 20.0;
+		parameters.Plunge = 10.0;
+		Anisotropy anisotropy(parameters);
+
+		// Test rotation alone preserves distances
+		EXPECT_TRUE(anisotropy.IsIsotropic());
+		EXPECT_NEAR(sqrt(14.0), TransformedLength(anisotropy, 1.0, 2.0, 3.0), mMaxError);
+	}
+
+	TEST(IsotropicCoordinatesTest, PrecomputedMatchesOnDemand)
+	{
+		std::vector<double> xs = { 1.0, 4.0, 8.0, 2.0 };
+		std::vector<double> ys = { 2.0, 6.0, 1.0, 8.0 };
+		std::vector<double> zs = { 3.0, 2.0, 7.0, 5.0 };
+		std::vector<double> grades = { 0.1, 0.4, 0.3, 0.8 };
+		Composites composites(xs, ys, zs, grades);
+
+		VariogramParameters parameters = InitAnisotropicParameters();
+		parameters.Azimuth = 60.0;
+		ThreadPool pool(2);
+		IsotropicCoordinates precomputed(composites, Anisotropy(parameters), true, &pool);
+		IsotropicCoordinates onDemand(composites, Anisotropy(parameters), false);
+
+		// Test both modes give the same coordinates
+		for (size_t i = 0; i < composites.GetSize(); i++)
+		{
+			double x1, y1, z1, x2, y2, z2;
+			precomputed.Get(i, x1, y1, z1);
+			onDemand.Get(i, x2, y2, z2);
+			EXPECT_EQ(x1, x2);
+			EXPECT_EQ(y1, y2);
+			EXPECT_EQ(z1, z2);
+		}
+	}
+}
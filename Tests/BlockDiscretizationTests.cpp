@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../KrigingLib/BlockDiscretization.hpp"
+#include "../KrigingLib/KrigingEngine.hpp"
+
+/**
+ * @brief Unit tests for block discretization and block kriging
+ */
+namespace BlockDiscretizationTests
+{
+	const double mMaxError = 1e-12;
+
+	static VariogramParameters InitVariogramParameters()
+	{
+		VariogramParameters parameters;
+		parameters.Nugget = 0.1;
+		parameters.Sill = 1.0;
+		parameters.Range = 40.0;
+		parameters.Structure = VariogramParameters::StructureType::Spherical;
+		return parameters;
+	}
+
+	TEST(BlockDiscretizationTest, PointSupportIsPointKriging)
+	{
+		VariogramModel model(InitVariogramParameters());
+		BlockDiscretization point(model);
+
+		// Test a single point gives the point variance and point covariances
+		EXPECT_EQ(1, point.GetNumPoints());
+		EXPECT_EQ(model.Covariance(0.0), point.GetBlockCovariance());
+
+		std::vector<double> xs = { 3.0, -4.0 }, ys = { 4.0, 0.0 }, zs = { 0.0, 3.0 };
+		std::vector<double> covariances(2), buffer(2);
+		point.BlockCovariances(0.0, 0.0, 0.0, xs.data(), ys.data(), zs.data(), 2, model, covariances.data(), buffer.data());
+		EXPECT_EQ(model.Covariance(5.0), covariances[0]);
+		EXPECT_EQ(model.Covariance(5.0), covariances[1]);
+	}
+
+	TEST(BlockDiscretizationTest, MatchesBruteForceAverages)
+	{
+		VariogramParameters parameters = InitVariogramParameters();
+		parameters.RangeSemiMajor = 20.0;
+		parameters.Azimuth = 30.0;
+		VariogramModel model(parameters);
+		const Anisotropy& anisotropy = model.GetAnisotropy();
+
+		BlockDiscretizationParameters counts;
+		counts.CountI = 4;
+		counts.CountJ = 4;
+		counts.CountK = 2;
+		double sizeX = 10.0, sizeY = 8.0, sizeZ = 4.0;
+		BlockDiscretization block(counts, sizeX, sizeY, sizeZ, model);
+		ASSERT_EQ(32, block.GetNumPoints());
+
+		// Reference: discretization points of a block centred on the origin, in model space
+		std::vector<double> px, py, pz;
+		for (int k = 0; k < 2; k++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				for (int i = 0; i < 4; i++)
+				{
+					px.push_back(-3.75 + 2.5 * i);
+					py.push_back(-3.0 + 2.0 * j);
+					pz.push_back(-1.0 + 2.0 * k);
+				}
+			}
+		}
+		auto covariance = [&](double dx, double dy, double dz) {
+			double tx, ty, tz;
+			anisotropy.Transform(dx, dy, dz, tx, ty, tz);
+			return model.Covariance(sqrt(tx * tx + ty * ty + tz * tz));
+		};
+
+		// Test C(V,V) is the average over all pairs of points, and smaller than the point variance
+		double blockCovariance = 0.0;
+		for (size_t a = 0; a < px.size(); ++a)
+		{
+			for (size_t b = 0; b < px.size(); ++b)
+			{
+				blockCovariance += covariance(px[a] - px[b], py[a] - py[b], pz[a] - pz[b]);
+			}
+		}
+		blockCovariance /= px.size() * px.size();
+		EXPECT_NEAR(blockCovariance, block.GetBlockCovariance(), mMaxError);
+		EXPECT_LT(block.GetBlockCovariance(), model.Covariance(0.0));
+
+		// Test sample-block covariances average over the points of the block centred on p0
+		double x0 = 12.0, y0 = -5.0, z0 = 2.0;
+		std::vector<double> xs = { 20.0, 5.0, 12.0 }, ys = { 0.0, -9.0, 10.0 }, zs = { 1.0, 6.0, -2.0 };
+		std::vector<double> txs(3), tys(3), tzs(3), covariances(3), buffer(3);
+		for (size_t s = 0; s < xs.size(); ++s)
+		{
+			anisotropy.Transform(xs[s], ys[s], zs[s], txs[s], tys[s], tzs[s]);
+		}
+		double tx0, ty0, tz0;
+		anisotropy.Transform(x0, y0, z0, tx0, ty0, tz0);
+		block.BlockCovariances(tx0, ty0, tz0, txs.data(), tys.data(), tzs.data(), 3, model, covariances.data(), buffer.data());
+		for (size_t s = 0; s < xs.size(); ++s)
+		{
+			double expected = 0.0;
+			for (size_t p = 0; p < px.size(); ++p)
+			{
+				expected += covariance(xs[s] - x0 - px[p], ys[s] - y0 - py[p], zs[s] - z0 - pz[p]);
+			}
+			EXPECT_NEAR(expected / px.size(), covariances[s], mMaxError);
+		}
+	}
+
+	TEST(BlockDiscretizationTest, BlockCovarianceExcludesNuggetOfCoincidentPairs)
+	{
+		VariogramParameters parameters = InitVariogramParameters();
+		parameters.Nugget = 0.4;
+		parameters.Range = 6.0;
+		VariogramModel model(parameters);
+
+		BlockDiscretizationParameters counts;
+		counts.CountI = 3;
+		counts.CountJ = 2;
+		counts.CountK = 2;
+		BlockDiscretization block(counts, 6.0, 4.0, 2.0, model);
+		ASSERT_EQ(12, block.GetNumPoints());
+
+		// Reference as in GSLIB kt3d: the covariance is the full sill at lag zero, less the nugget for coincident pairs
+		std::vector<double> offsetX(12), offsetY(12), offsetZ(12);
+		for (size_t p = 0; p < 12; ++p)
+		{
+			block.GetOffset(p, offsetX[p], offsetY[p], offsetZ[p]);
+		}
+		double blockCovariance = 0.0;
+		for (size_t a = 0; a < 12; ++a)
+		{
+			for (size_t b = 0; b < 12; ++b)
+			{
+				double dx = offsetX[a] - offsetX[b], dy = offsetY[a] - offsetY[b], dz = offsetZ[a] - offsetZ[b];
+				double h = sqrt(dx * dx + dy * dy + dz * dz);
+				double covariance = h == 0.0 ? model.GetSill() : model.Covariance(h);
+				if (a == b)
+				{
+					covariance -= parameters.Nugget;
+				}
+				blockCovariance += covariance;
+			}
+		}
+		blockCovariance /= 12.0 * 12.0;
+
+		// Test the nugget is removed from the 12 coincident pairs exactly once
+		EXPECT_NEAR(blockCovariance, block.GetBlockCovariance(), mMaxError);
+		EXPECT_LT(block.GetBlockCovariance(), model.GetSill() - parameters.Nugget);
+	}
+
+	TEST(BlockDiscretizationTest, BlockKrigingReducesKrigingVariance)
+	{
+		std::vector<double> xs = { 2.0, 8.0, 5.0, 1.0 };
+		std::vector<double> ys = { 1.0, 3.0, 9.0, 6.0 };
+		std::vector<double> zs = { 0.0, 1.0, 2.0, 1.0 };
+		Composites composites(xs, ys, zs, std::vector<double>(xs.size(), 1.5));
+
+		KrigingParameters parameters;
+		parameters.MinNumComposites = 1;
+		parameters.MaxNumComposites = 8;
+		parameters.MaxRadius = 100;
+		parameters.VariogramParameters = InitVariogramParameters();
+		parameters.BlockParameters.BlockCoordExtents = { 0.0, 0.0, 0.0, 10.0, 10.0, 4.0 };
+		parameters.BlockParameters.BlockCountI = 1;
+		parameters.BlockParameters.BlockCountJ = 1;
+		parameters.BlockParameters.BlockCountK = 1;
+
+		KrigingDiagnostics pointDiagnostics, blockDiagnostics;
+		auto pointEstimates = KrigingEngine::KrigeOneBlock(5.0, 5.0, 2.0, parameters, composites, &pointDiagnostics);
+		parameters.BlockDiscretization.CountI = 4;
+		parameters.BlockDiscretization.CountJ = 4;
+		parameters.BlockDiscretization.CountK = 2;
+		auto blockEstimates = KrigingEngine::KrigeOneBlock(5.0, 5.0, 2.0, parameters, composites, &blockDiagnostics);
+		ASSERT_TRUE(pointEstimates.has_value());
+		ASSERT_TRUE(blockEstimates.has_value());
+
+		// Test a constant field is still reproduced, with a smaller variance for the block than for its centroid
+		EXPECT_NEAR(1.5, blockEstimates.value()[0], 1e-9);
+		EXPECT_GT(blockDiagnostics.KrigingVariance, 0.0);
+		EXPECT_LT(blockDiagnostics.KrigingVariance, pointDiagnostics.KrigingVariance);
+	}
+}
@@ -39,5 +39,63 @@ namespace BlockTests
       EXPECT_NEAR(22.5, blocks.GetY(index), maxError);
       EXPECT_NEAR(16.25, blocks.GetZ(index), maxError);
    }
+
+   TEST(TestCreateBlocks, ComputesCentroidsFromGridIndices)
+   {
+      CoordinateExtents modelExtents;
+      modelExtents.MinX = 20;
+      modelExtents.MinY = 20;
+      modelExtents.MinZ = 15;
+      modelExtents.MaxX = 100;
+      modelExtents.MaxY = 100;
+      modelExtents.MaxZ = 50;
+
+      BlockModelInfo modelInfo;
+      modelInfo.BlockCoordExtents = modelExtents;
+      modelInfo.BlockCountI = 16;
+      modelInfo.BlockCountJ = 8;
+      modelInfo.BlockCountK = 14;
+
+      Blocks blocks(modelInfo);
+
+      // Block (i,j,k) = (3,5,7) with i varying fastest
+      double maxError = 0.0001;
+      size_t index = 3 + 5 * 16 + 7 * 16 * 8;
+      EXPECT_NEAR(20 + 3.5 * 5.0, blocks.GetX(index), maxError);
+      EXPECT_NEAR(20 + 5.5 * 10.0, blocks.GetY(index), maxError);
+      EXPECT_NEAR(15 + 7.5 * 2.5, blocks.GetZ(index), maxError);
+
+      // Spot check last centroid
+      index = blocks.GetSize() - 1;
+      EXPECT_NEAR(97.5, blocks.GetX(index), maxError);
+      EXPECT_NEAR(95, blocks.GetY(index), maxError);
+      EXPECT_NEAR(48.75, blocks.GetZ(index), maxError);
+   }
+
+   TEST(TestGradeColumn, StoresGradesWithNotEstimatedSentinel)
+   {
+      for (auto precision : { KrigingParameters::PrecisionType::Double, KrigingParameters::PrecisionType::Float })
+      {
+         GradeColumn grades(3, precision);
+
+         // Test all grades start as not estimated
+         EXPECT_FALSE(grades[0].has_value());
+         EXPECT_FALSE(grades.HasValue(2));
+
+         grades.Set(0, 0.125);
+         grades.Set(1, 1.0 / 3.0);
+         grades.Set(2, 0.5);
+         grades.Reset(2);
+
+         EXPECT_DOUBLE_EQ(0.125, grades[0].value());
+         EXPECT_NEAR(1.0 / 3.0, grades[1].value(), 1e-7);
+         EXPECT_FALSE(grades[2].has_value());
+      }
+
+      // Test float storage halves grade memory
+      GradeColumn floatGrades(10, KrigingParameters::PrecisionType::Float);
+      EXPECT_EQ(10, floatGrades.GetFloatValues().size());
+      EXPECT_TRUE(floatGrades.GetDoubleValues().empty());
+   }
 }
 
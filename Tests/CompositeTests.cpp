@@ -4,6 +4,7 @@
 #include <iostream>
 #include <vector>
 #include <filesystem>
+#include <fstream>
 
 //TODO: Update solution structure so cpp references are not needed in test project
 #include "gtest/gtest.h"
@@ -91,6 +92,102 @@ namespace CompositeTests
 		EXPECT_EQ(2.0, result.Distances.size());
 	}
 
+	TEST(FindNearestCompositesReusedResultTest, ReusesResultBuffers)
+	{
+		std::vector<double> xs = { 1.0, 2.0, 3.0, 4.0, 5.0 };
+		std::vector<double> ys = { 1.0, 2.0, 3.0, 4.0, 5.0 };
+		std::vector<double> zs = { 1.0, 2.0, 3.0, 4.0, 5.0 };
+		std::vector<double> grades = { 1.0, 2.0, 3.0, 4.0, 5.0 };
+		Composites composites(xs, ys, zs, grades);
+
+		int numComposites = 3;
+		NearestCompositesResult result;
+		result.Indices.reserve(numComposites);
+		result.Distances.reserve(numComposites);
+		const size_t* indicesData = result.Indices.data();
+
+		// Search with a small radius first, then a large radius, into the same result
+		composites.FindNearestComposites(2.5, 2.5, 2.5, numComposites, 1.0, result);
+		EXPECT_EQ(2, result.Indices.size());
+
+		composites.FindNearestComposites(2.432, 2.972, 3.152, numComposites, 10000, result);
+		NearestCompositesResult expected = composites.FindNearestComposites(2.432, 2.972, 3.152, numComposites, 10000);
+
+		// Test results match the allocating overload and buffers were not reallocated
+		EXPECT_EQ(expected.Indices, result.Indices);
+		EXPECT_EQ(expected.Distances, result.Distances);
+		EXPECT_EQ(indicesData, result.Indices.data());
+	}
+
+	TEST(FindNearestCompositesBoundedTest, IncludesCompositesAtMaxDistance)
+	{
+		std::vector<double> xs = { 0.0, 3.0, 0.0, 50.0, 80.0 };
+		std::vector<double> ys = { 0.0, 0.0, 4.0, 50.0, 80.0 };
+		std::vector<double> zs = { 0.0, 0.0, 0.0, 50.0, 80.0 };
+		std::vector<double> grades = { 1.0, 2.0, 3.0, 4.0, 5.0 };
+		Composites composites(xs, ys, zs, grades);
+
+		// Search for more composites than lie within the radius; the composite at exactly maxDist is kept
+		NearestCompositesResult result = composites.FindNearestComposites(0.0, 0.0, 0.0, 4, 4.0);
+		ASSERT_EQ(3, result.Indices.size());
+		EXPECT_EQ(0, result.Indices[0]);
+		EXPECT_EQ(1, result.Indices[1]);
+		EXPECT_EQ(2, result.Indices[2]);
+		EXPECT_DOUBLE_EQ(4.0, result.Distances[2]);
+	}
+
+	TEST(FindNearestCandidatesTest, MatchesKdTreeSearch)
+	{
+		std::vector<double> xs = { 1.0, 4.0, 8.0, 2.0, 9.0, 5.0, 7.0 };
+		std::vector<double> ys = { 2.0, 6.0, 1.0, 8.0, 9.0, 5.0, 3.0 };
+		std::vector<double> zs = { 3.0, 2.0, 7.0, 5.0, 1.0, 9.0, 6.0 };
+		std::vector<double> grades = { 0.1, 0.4, 0.3, 0.8, 0.2, 0.5, 0.6 };
+		Composites composites(xs, ys, zs, grades);
+
+		// Candidates around (5,5,5) cover any point within 1 unit when searching up to 6 units
+		CompositeCandidates candidates;
+		composites.FindCandidateComposites(5.0, 5.0, 5.0, 7.0, candidates);
+
+		NearestCompositesResult result;
+		composites.FindNearestCandidates(5.5, 4.5, 5.2, 4, 6.0, candidates, result);
+		NearestCompositesResult expected = composites.FindNearestComposites(5.5, 4.5, 5.2, 4, 6.0);
+
+		// Test results match the kd-tree search
+		EXPECT_EQ(expected.Indices, result.Indices);
+		EXPECT_EQ(expected.Distances, result.Distances);
+	}
+
+	TEST(FindNeighbouringCompositesTest, ExcludesSearchComposite)
+	{
+		std::string filePath = TestHelpers::GetTestDataFilePath("ExComposites10k.csv");
+		CoordinateExtents modelExtents = InitCoordExtents();
+
+		// Search ellipsoid, so the composite's stored search coordinates are transformed
+		Anisotropy searchAnisotropy(40.0, 20.0, 10.0, 30.0, 10.0, 0.0);
+		Composites composites(filePath, modelExtents, 40, { "Grade" }, 0, false, 10, searchAnisotropy);
+
+		NearestCompositesResult result;
+		for (size_t i = 0; i < composites.GetSize(); i += 97)
+		{
+			composites.FindNeighbouringComposites(i, 12, 40, result);
+
+			// Test results match a search from the composite for one more neighbour, without the composite itself
+			NearestCompositesResult expected = composites.FindNearestComposites(composites.GetX(i), composites.GetY(i), composites.GetZ(i), 13, 40);
+			auto self = std::find(expected.Indices.begin(), expected.Indices.end(), i);
+			ASSERT_NE(expected.Indices.end(), self);
+			expected.Distances.erase(expected.Distances.begin() + (self - expected.Indices.begin()));
+			expected.Indices.erase(self);
+			expected.Indices.resize(std::min<size_t>(expected.Indices.size(), 12));
+			expected.Distances.resize(expected.Indices.size());
+
+			EXPECT_EQ(expected.Indices, result.Indices);
+			for (size_t k = 0; k < expected.Distances.size(); k++)
+			{
+				EXPECT_NEAR(expected.Distances[k], result.Distances[k], 1e-9);
+			}
+		}
+	}
+
 	TEST(PerformanceTest, KDTreeFasterThanNaive)
 	{
 		int numComposites = 10000;
@@ -198,4 +295,263 @@ namespace CompositeTests
 		// Confirm an exception is thrown; at least one valid composite is required
 		EXPECT_THROW(Composites composites(filePath, modelExtents, searchRadius), std::invalid_argument);
 	}
+
+	TEST(ImportCompositesTest, ParsesMixedFormatRows)
+	{
+		// CRLF line endings, padded and signed values, short and empty rows, no newline at end of file
+		std::string filePath = TestHelpers::GetTestDataFilePath("ExComposites6MixedFormat.csv");
+
+		CoordinateExtents modelExtents = InitCoordExtents();
+		double searchRadius = 100;
+
+		Composites composites(filePath, modelExtents, searchRadius);
+
+		// Test short and empty rows are skipped, and values are parsed correctly
+		ASSERT_EQ(4, composites.GetSize());
+		EXPECT_DOUBLE_EQ(54.876, composites.GetY(0));
+		EXPECT_DOUBLE_EQ(93.195, composites.GetX(1));
+		EXPECT_DOUBLE_EQ(0.1, composites.GetGrade(2));
+		EXPECT_DOUBLE_EQ(0.761, composites.GetGrade(3));
+	}
+
+	TEST(ImportCompositesTest, ParallelImportKeepsFileOrder)
+	{
+		// Write a file large enough to be split into several chunks, with some invalid and irrelevant rows
+		std::string filePath = (std::filesystem::temp_directory_path() / "ParallelImportComposites.csv").string();
+		{
+			std::ofstream file(filePath);
+			file << "X,Y,Z,Grade\n";
+			for (int i = 0; i < 400000; i++)
+			{
+				if (i % 1000 == 7)
+				{
+					file << "bad,row\n";
+				}
+				else
+				{
+					file << (i % 997) * 0.1 << "," << (i % 1009) * 0.1 << "," << (i % 113) * 0.5 - 100 << "," << i << "\n";
+				}
+			}
+		}
+
+		CoordinateExtents modelExtents = InitCoordExtents();
+		Composites serial(filePath, modelExtents, 100, { "Grade" }, 1);
+		Composites parallel(filePath, modelExtents, 100, { "Grade" }, 4);
+		std::filesystem::remove(filePath);
+
+		// Test composites are identical and in file order
+		ASSERT_EQ(serial.GetSize(), parallel.GetSize());
+		for (size_t i = 0; i < serial.GetSize(); i++)
+		{
+			ASSERT_EQ(serial.GetX(i), parallel.GetX(i));
+			ASSERT_EQ(serial.GetZ(i), parallel.GetZ(i));
+			ASSERT_EQ(serial.GetGrade(i), parallel.GetGrade(i));
+			if (i > 0)
+			{
+				ASSERT_LT(parallel.GetGrade(i - 1), parallel.GetGrade(i));
+			}
+		}
+	}
+
+	TEST(KdTreeBuildTest, ParallelBuildMatchesSerialBuild)
+	{
+		std::string filePath = TestHelpers::GetTestDataFilePath("ExComposites10k.csv");
+		CoordinateExtents modelExtents = InitCoordExtents();
+
+		// Serial build with the default leaf size, and parallel builds with small and large leaves
+		Composites serial(filePath, modelExtents, 100, { "Grade" }, 1);
+		Composites parallel(filePath, modelExtents, 100, { "Grade" }, 4, false, 4);
+		Composites parallelLargeLeaves(filePath, modelExtents, 100, { "Grade" }, 4, false, 64);
+
+		// Test searches return the same composites
+		for (int i = 0; i < 50; i++)
+		{
+			double x = rand() % 101;
+			double y = rand() % 101;
+			double z = rand() % 101;
+			NearestCompositesResult expected = serial.FindNearestComposites(x, y, z, 16, 50);
+			NearestCompositesResult result = parallel.FindNearestComposites(x, y, z, 16, 50);
+			EXPECT_EQ(expected.Distances, result.Distances);
+			result = parallelLargeLeaves.FindNearestComposites(x, y, z, 16, 50);
+			EXPECT_EQ(expected.Distances, result.Distances);
+		}
+	}
+
+	TEST(EllipsoidSearchTest, MatchesNaiveSearch)
+	{
+		std::string filePath = TestHelpers::GetTestDataFilePath("ExComposites10k.csv");
+		CoordinateExtents modelExtents = InitCoordExtents();
+
+		// Search ellipsoid of 60 x 30 x 10 units, rotated on all three axes
+		Anisotropy searchAnisotropy(60.0, 30.0, 10.0, 45.0, 20.0, 10.0);
+		Composites composites(filePath, modelExtents, 60, { "Grade" }, 0, false, 10, searchAnisotropy);
+
+		for (int i = 0; i < 50; i++)
+		{
+			double x = rand() % 101;
+			double y = rand() % 101;
+			double z = rand() % 101;
+
+			// Naive search of the anisotropic distances within the major range
+			std::vector<double> expected;
+			for (size_t j = 0; j < composites.GetSize(); j++)
+			{
+				double distance = composites.GetSearchDistance(composites.GetX(j) - x, composites.GetY(j) - y, composites.GetZ(j) - z);
+				if (distance <= 60.0)
+				{
+					expected.push_back(distance);
+				}
+			}
+			std::sort(expected.begin(), expected.end());
+			expected.resize(std::min<size_t>(expected.size(), 16));
+
+			// Test the kd-tree search in the transformed space finds the same distances
+			NearestCompositesResult result = composites.FindNearestComposites(x, y, z, 16, 60);
+			ASSERT_EQ(expected.size(), result.Distances.size());
+			for (size_t k = 0; k < expected.size(); k++)
+			{
+				EXPECT_NEAR(expected[k], result.Distances[k], 1e-9);
+			}
+		}
+	}
+
+	TEST(BinaryCompositesTest, SaveAndLoadRoundTrip)
+	{
+		std::vector<double> xs = { 1.0, 4.0, 8.0 };
+		std::vector<double> ys = { 2.0, 6.0, 1.0 };
+		std::vector<double> zs = { 3.0, 2.0, 7.0 };
+		std::vector<std::vector<double>> values = { { 0.1, 0.4, 0.3 }, { 1.5, 2.5, 3.5 } };
+		Composites composites(xs, ys, zs, values, { "Au", "Cu" });
+
+		std::string filePath = (std::filesystem::temp_directory_path() / "RoundTripComposites.bin").string();
+		composites.SaveBinary(filePath);
+		auto loaded = Composites::LoadBinary(filePath);
+		std::filesystem::remove(filePath);
+
+		// Test columns and variable names are restored exactly
+		ASSERT_EQ(composites.GetSize(), loaded->GetSize());
+		EXPECT_EQ(composites.GetVariableNames(), loaded->GetVariableNames());
+		for (size_t i = 0; i < composites.GetSize(); i++)
+		{
+			EXPECT_EQ(composites.GetX(i), loaded->GetX(i));
+			EXPECT_EQ(composites.GetY(i), loaded->GetY(i));
+			EXPECT_EQ(composites.GetZ(i), loaded->GetZ(i));
+			EXPECT_EQ(composites.GetValue(i, 1), loaded->GetValue(i, 1));
+		}
+	}
+
+	TEST(BinaryCompositesTest, SaveReplacesExistingFile)
+	{
+		std::filesystem::path directory = std::filesystem::temp_directory_path() / "ReplacedComposites";
+		std::filesystem::create_directories(directory);
+		std::string filePath = (directory / "Composites.bin").string();
+
+		Composites first({ 1.0, 2.0 }, { 1.0, 2.0 }, { 1.0, 2.0 }, { 0.5, 0.6 });
+		Composites second({ 4.0, 5.0, 6.0 }, { 4.0, 5.0, 6.0 }, { 4.0, 5.0, 6.0 }, { 0.7, 0.8, 0.9 });
+		first.SaveBinary(filePath);
+		second.SaveBinary(filePath);
+		auto loaded = Composites::LoadBinary(filePath);
+
+		// Test the second save replaced the file, with no temporary files left beside it
+		EXPECT_EQ(3, loaded->GetSize());
+		size_t numFiles = std::distance(std::filesystem::directory_iterator(directory), std::filesystem::directory_iterator());
+		loaded.reset();
+		std::filesystem::remove_all(directory);
+		EXPECT_EQ(1, numFiles);
+	}
+
+	TEST(BinaryCompositesTest, ReusesStoredIndex)
+	{
+		std::vector<double> xs, ys, zs, grades;
+		for (int i = 0; i < 1000; i++)
+		{
+			xs.push_back(rand() % 101);
+			ys.push_back(rand() % 101);
+			zs.push_back(rand() % 101);
+			grades.push_back(i);
+		}
+		Composites composites(xs, ys, zs, grades);
+
+		std::string filePath = (std::filesystem::temp_directory_path() / "IndexComposites.bin").string();
+		composites.SaveBinary(filePath);
+		auto loaded = Composites::LoadBinary(filePath);
+
+		// Corrupt the last byte of the stored index; the index is rebuilt rather than reused
+		{
+			std::fstream file(filePath, std::ios::in | std::ios::out | std::ios::binary);
+			file.seekg(-1, std::ios::end);
+			char last = static_cast<char>(file.get());
+			file.seekp(-1, std::ios::end);
+			file.put(static_cast<char>(~last));
+		}
+		auto rebuilt = Composites::LoadBinary(filePath);
+		std::filesystem::remove(filePath);
+
+		// Test searches match the original index
+		for (int i = 0; i < 20; i++)
+		{
+			double x = rand() % 101;
+			double y = rand() % 101;
+			double z = rand() % 101;
+			NearestCompositesResult expected = composites.FindNearestComposites(x, y, z, 8, 30);
+			EXPECT_EQ(expected.Indices, loaded->FindNearestComposites(x, y, z, 8, 30).Indices);
+			EXPECT_EQ(expected.Indices, rebuilt->FindNearestComposites(x, y, z, 8, 30).Indices);
+		}
+	}
+
+	TEST(BinaryCompositesTest, LoadThrowsOnInvalidFile)
+	{
+		// A CSV file is not a valid binary composite file
+		std::string filePath = TestHelpers::GetTestDataFilePath("ExComposites10.csv");
+
+		EXPECT_THROW(Composites::LoadBinary(filePath), std::runtime_error);
+	}
+
+	TEST(BinaryCompositesTest, CacheReloadsMatchingImport)
+	{
+		// Copy the CSV so the cache file is written to a temporary directory
+		std::filesystem::path csvPath = std::filesystem::temp_directory_path() / "CachedComposites.csv";
+		std::filesystem::copy_file(TestHelpers::GetTestDataFilePath("ExComposites10.csv"), csvPath,
+			std::filesystem::copy_options::overwrite_existing);
+		std::string cachePath = csvPath.string() + ".cache";
+		std::filesystem::remove(cachePath);
+
+		CoordinateExtents modelExtents = InitCoordExtents();
+		Composites parsed(csvPath.string(), modelExtents, 100, { "Grade" }, 0, true);
+		ASSERT_TRUE(std::filesystem::exists(cachePath));
+		Composites cached(csvPath.string(), modelExtents, 100, { "Grade" }, 0, true);
+
+		// A different search radius does not match the cache; the cache is rewritten for the new settings
+		Composites reparsed(csvPath.string(), modelExtents, 50, { "Grade" }, 0, true);
+
+		// Nor does a different search ellipsoid, whose kd-tree indexes transformed coordinates
+		Anisotropy searchAnisotropy(50.0, 25.0, 10.0, 30.0, 0.0, 0.0);
+		Composites ellipsoid(csvPath.string(), modelExtents, 50, { "Grade" }, 0, true, 10, searchAnisotropy);
+		Composites ellipsoidCached(csvPath.string(), modelExtents, 50, { "Grade" }, 0, true, 10, searchAnisotropy);
+
+		std::filesystem::remove(cachePath);
+		std::filesystem::remove(csvPath);
+
+		// Test cached composites match the parsed composites
+		ASSERT_EQ(parsed.GetSize(), cached.GetSize());
+		for (size_t i = 0; i < parsed.GetSize(); i++)
+		{
+			EXPECT_EQ(parsed.GetX(i), cached.GetX(i));
+			EXPECT_EQ(parsed.GetGrade(i), cached.GetGrade(i));
+		}
+		EXPECT_LE(reparsed.GetSize(), parsed.GetSize());
+
+		// Test the cached ellipsoid search matches the parsed one
+		NearestCompositesResult expected = ellipsoid.FindNearestComposites(50.0, 50.0, 30.0, 4, 50);
+		NearestCompositesResult result = ellipsoidCached.FindNearestComposites(50.0, 50.0, 30.0, 4, 50);
+		EXPECT_EQ(expected.Indices, result.Indices);
+		EXPECT_EQ(expected.Distances, result.Distances);
+	}
+
+	TEST(ImportCompositesTest, ThrowsOnMissingFile)
+	{
+		CoordinateExtents modelExtents = InitCoordExtents();
+
+		EXPECT_THROW(Composites composites("MissingComposites.csv", modelExtents, 100), std::runtime_error);
+	}
 }
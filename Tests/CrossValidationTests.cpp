@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../KrigingLib/CrossValidation.hpp"
+#include "../KrigingLib/KrigingEngine.hpp"
+
+/**
+ * @brief Unit tests for leave-one-out cross-validation
+ */
+namespace CrossValidationTests
+{
+	const double mMaxError = 1e-8;
+
+	static KrigingParameters InitKrigingParameters()
+	{
+		KrigingParameters parameters;
+		parameters.MinNumComposites = 1;
+		parameters.MaxNumComposites = 16;
+		parameters.MaxRadius = 100;
+		parameters.NumThreads = 2;
+		parameters.VariogramParameters.Nugget = 0.1;
+		parameters.VariogramParameters.Sill = 1.0;
+		parameters.VariogramParameters.Range = 8.0;
+		parameters.VariogramParameters.Structure = VariogramParameters::StructureType::Spherical;
+		return parameters;
+	}
+
+	static void InitComposites(size_t numComposites, std::vector<double>& xs, std::vector<double>& ys, std::vector<double>& zs,
+		std::vector<double>& grades)
+	{
+		std::mt19937 generator(3);
+		std::uniform_real_distribution<double> distribution(0.0, 10.0);
+		for (size_t i = 0; i < numComposites; i++)
+		{
+			xs.push_back(distribution(generator));
+			ys.push_back(distribution(generator));
+			zs.push_back(distribution(generator));
+			grades.push_back(0.1 * xs.back() + 0.1 * distribution(generator));
+		}
+	}
+
+	/**
+	 * @brief Tests cross-validation matches kriging each composite from a copy of the composites without it
+	 */
+	static void ExpectMatchesRemovedComposites(const KrigingParameters& parameters, const std::vector<double>& xs,
+		const std::vector<double>& ys, const std::vector<double>& zs, const std::vector<double>& grades)
+	{
+		Composites composites(xs, ys, zs, grades);
+		CrossValidationResults results = KrigingEngine::CrossValidate(parameters, composites);
+		ASSERT_EQ(1, results.Estimates.size());
+		ASSERT_EQ(xs.size(), results.Estimates[0].size());
+
+		for (size_t i = 0; i < xs.size(); i++)
+		{
+			std::vector<double> otherXs = xs, otherYs = ys, otherZs = zs, otherGrades = grades;
+			otherXs.erase(otherXs.begin() + i);
+			otherYs.erase(otherYs.begin() + i);
+			otherZs.erase(otherZs.begin() + i);
+			otherGrades.erase(otherGrades.begin() + i);
+			Composites others(otherXs, otherYs, otherZs, otherGrades);
+
+			KrigingDiagnostics diagnostics;
+			auto expected = KrigingEngine::KrigeOneBlock(xs[i], ys[i], zs[i], parameters, others, &diagnostics);
+			if (!expected.has_value())
+			{
+				EXPECT_TRUE(std::isnan(results.Estimates[0][i]));
+				continue;
+			}
+			EXPECT_NEAR(expected.value()[0], results.Estimates[0][i], mMaxError);
+			EXPECT_NEAR(diagnostics.KrigingVariance, results.KrigingVariances[i], mMaxError);
+		}
+	}
+
+	TEST(CrossValidationTest, UniqueNeighbourhoodMatchesRemovedComposites)
+	{
+		std::vector<double> xs, ys, zs, grades;
+		InitComposites(12, xs, ys, zs, grades);
+
+		// Every composite's neighbourhood holds the other 11, so the estimates come from one factorization
+		KrigingParameters parameters = InitKrigingParameters();
+		ExpectMatchesRemovedComposites(parameters, xs, ys, zs, grades);
+
+		parameters.Type = KrigingParameters::KrigingType::Simple;
+		parameters.GlobalMeans = { 0.7 };
+		ExpectMatchesRemovedComposites(parameters, xs, ys, zs, grades);
+
+		parameters.Type = KrigingParameters::KrigingType::Universal;
+		ExpectMatchesRemovedComposites(parameters, xs, ys, zs, grades);
+	}
+
+	TEST(CrossValidationTest, MovingNeighbourhoodMatchesRemovedComposites)
+	{
+		std::vector<double> xs, ys, zs, grades;
+		InitComposites(150, xs, ys, zs, grades);
+
+		// Small neighbourhoods, and a radius that leaves some composites with too few neighbours
+		KrigingParameters parameters = InitKrigingParameters();
+		parameters.MinNumComposites = 3;
+		parameters.MaxNumComposites = 8;
+		parameters.MaxRadius = 1.6;
+		ExpectMatchesRemovedComposites(parameters, xs, ys, zs, grades);
+
+		parameters.MaxRadius = 4.0;
+		parameters.Type = KrigingParameters::KrigingType::Universal;
+		ExpectMatchesRemovedComposites(parameters, xs, ys, zs, grades);
+	}
+
+	TEST(CrossValidationTest, DuplicateLocationsMatchRemovedComposites)
+	{
+		std::vector<double> xs = { 0.0, 3.0, 1.0, 4.0, 4.0, 2.0 };
+		std::vector<double> ys = { 0.0, 1.0, 4.0, 3.0, 3.0, 2.0 };
+		std::vector<double> zs = { 0.0, 0.0, 1.0, 1.0, 1.0, 2.0 };
+		std::vector<double> grades = { 1.0, 2.0, 3.0, 4.0, 4.5, 2.5 };
+
+		// Two composites at one location make the full kriging matrix singular, so each composite is estimated alone
+		KrigingParameters parameters = InitKrigingParameters();
+		parameters.VariogramParameters.Nugget = 0.0;
+		ExpectMatchesRemovedComposites(parameters, xs, ys, zs, grades);
+
+		parameters.Type = KrigingParameters::KrigingType::Simple;
+		parameters.GlobalMeans = { 2.5 };
+		ExpectMatchesRemovedComposites(parameters, xs, ys, zs, grades);
+	}
+
+	TEST(CrossValidationTest, ComputesErrorStatistics)
+	{
+		std::vector<double> xs = { 0.0, 1.0, 2.0, 3.0 }, ys(4, 0.0), zs(4, 0.0);
+		Composites composites(xs, ys, zs, { 1.0, 2.0, 3.0, 4.0 });
+
+		CrossValidationResults results(4, 1);
+		results.Estimates[0] = { 1.5, 1.5, 3.5, std::numeric_limits<double>::quiet_NaN() };
+		results.KrigingVariances = { 0.25, 1.0, 0.25, std::numeric_limits<double>::quiet_NaN() };
+		results.ComputeStatistics(composites);
+
+		// Test statistics cover the estimated composites only, with errors 0.5, -0.5, 0.5
+		const auto& statistics = results.Statistics[0];
+		EXPECT_EQ(3, statistics.NumEstimated);
+		EXPECT_NEAR(0.5 / 3, statistics.MeanError, mMaxError);
+		EXPECT_NEAR(0.5, statistics.MeanAbsoluteError, mMaxError);
+		EXPECT_NEAR(0.5, statistics.RootMeanSquaredError, mMaxError);
+		EXPECT_NEAR((1.0 + 0.25 + 1.0) / 3, statistics.MeanSquaredStandardizedError, mMaxError);
+		EXPECT_NEAR(0.866025403784, statistics.Correlation, mMaxError);
+
+		// Test a zero variance is left out of the standardized error only
+		results.KrigingVariances[1] = 0.0;
+		results.ComputeStatistics(composites);
+		EXPECT_EQ(3, results.Statistics[0].NumEstimated);
+		EXPECT_NEAR(0.5, results.Statistics[0].RootMeanSquaredError, mMaxError);
+		EXPECT_NEAR((1.0 + 1.0) / 2, results.Statistics[0].MeanSquaredStandardizedError, mMaxError);
+	}
+}
@@ -193,6 +193,664 @@ namespace KrigingEngineTests
 		ASSERT_NEAR(0.4, okResult2, 0.15);
 	}
 
+	TEST_F(KrigingTests, OrdinaryKrigingCholeskyMatchesQRTest)
+	{
+		// Define the coordinates and values of the composites
+		std::vector<double> xs = { 0.0, 1.0, 2.0, 3.0, 4.0, 0.5 };
+		std::vector<double> ys = { 0.0, 1.5, 2.0, 3.5, 4.0, 2.5 };
+		std::vector<double> zs = { 0.0, 1.0, 2.5, 3.0, 4.0, 1.0 };
+		std::vector<double> grades = { 0.10, 0.12, 0.82, 0.75, 0.21, 0.33 };
+
+		// Define the point to be estimated
+		double x0 = 2.5;
+		double y0 = 2.0;
+		double z0 = 1.5;
+
+		// Perform ordinary kriging with each solver
+		double choleskyResult = KrigingEngine::OrdinaryKrigingPoint(x0, y0, z0, xs, ys, zs, grades, mParameters,
+			KrigingParameters::SolverType::Cholesky);
+		double qrResult = KrigingEngine::OrdinaryKrigingPoint(x0, y0, z0, xs, ys, zs, grades, mParameters,
+			KrigingParameters::SolverType::QR);
+
+		ASSERT_NEAR(qrResult, choleskyResult, mMaxError);
+	}
+
+	TEST_F(KrigingTests, OrdinaryKrigingCholeskyDuplicateSamplesFallsBackToQRTest)
+	{
+		// Duplicate sample locations make the covariance block singular
+		std::vector<double> xs = { 1.0, 1.0, 3.0 };
+		std::vector<double> ys = { 1.0, 1.0, 3.0 };
+		std::vector<double> zs = { 1.0, 1.0, 3.0 };
+		std::vector<double> grades = { 0.2, 0.2, 0.6 };
+
+		double choleskyResult = KrigingEngine::OrdinaryKrigingPoint(2.0, 2.0, 2.0, xs, ys, zs, grades, mParameters,
+			KrigingParameters::SolverType::Cholesky);
+		double qrResult = KrigingEngine::OrdinaryKrigingPoint(2.0, 2.0, 2.0, xs, ys, zs, grades, mParameters,
+			KrigingParameters::SolverType::QR);
+
+		ASSERT_TRUE(std::isfinite(choleskyResult));
+		ASSERT_NEAR(qrResult, choleskyResult, mMaxError);
+	}
+
+	TEST_F(KrigingTests, SimpleKrigingMatchesDirectSolveTest)
+	{
+		std::vector<double> xs = { 0.0, 1.0, 2.0, 3.0, 4.0, 0.5 };
+		std::vector<double> ys = { 0.0, 1.5, 2.0, 3.5, 4.0, 2.5 };
+		std::vector<double> zs = { 0.0, 1.0, 2.5, 3.0, 4.0, 1.0 };
+		std::vector<double> grades = { 0.10, 0.12, 0.82, 0.75, 0.21, 0.33 };
+		Composites composites(xs, ys, zs, grades);
+
+		KrigingParameters parameters;
+		parameters.Type = KrigingParameters::KrigingType::Simple;
+		parameters.GlobalMeans = { 0.4 };
+		parameters.MinNumComposites = 1;
+		parameters.MaxNumComposites = 10;
+		parameters.MaxRadius = 100;
+		parameters.VariogramParameters = mParameters;
+
+		// Reference: solve K * w = k0 without the unbiasedness constraint
+		double x0 = 2.5, y0 = 2.0, z0 = 1.5;
+		size_t n = xs.size();
+		Eigen::MatrixXd K(n, n);
+		Eigen::VectorXd k0(n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			for (size_t j = 0; j < n; ++j)
+			{
+				double h = sqrt(pow(xs[i] - xs[j], 2) + pow(ys[i] - ys[j], 2) + pow(zs[i] - zs[j], 2));
+				K(i, j) = KrigingEngine::Covariance(h, mParameters);
+			}
+			double h0 = sqrt(pow(xs[i] - x0, 2) + pow(ys[i] - y0, 2) + pow(zs[i] - z0, 2));
+			k0(i) = KrigingEngine::Covariance(h0, mParameters);
+		}
+		Eigen::VectorXd w = K.ldlt().solve(k0);
+		double expected = 0.4;
+		for (size_t i = 0; i < n; ++i)
+		{
+			expected += w(i) * (grades[i] - 0.4);
+		}
+
+		// Test both solvers give the reference estimate, with variance C(0) - w'k0 and a slope of one
+		for (auto solver : { KrigingParameters::SolverType::Cholesky, KrigingParameters::SolverType::QR })
+		{
+			parameters.Solver = solver;
+			KrigingDiagnostics diagnostics;
+			auto estimates = KrigingEngine::KrigeOneBlock(x0, y0, z0, parameters, composites, &diagnostics);
+			ASSERT_TRUE(estimates.has_value());
+			EXPECT_NEAR(expected, estimates.value()[0], mMaxError);
+			EXPECT_NEAR(KrigingEngine::Covariance(0.0, mParameters) - w.dot(k0), diagnostics.KrigingVariance, mMaxError);
+			EXPECT_NEAR(1.0, diagnostics.SlopeOfRegression, mMaxError);
+		}
+	}
+
+	TEST_F(KrigingTests, SimpleKrigingBeyondRangeReturnsCompositeMeanTest)
+	{
+		std::vector<double> xs = { 0.0, 1.0, 0.0 };
+		std::vector<double> ys = { 0.0, 0.0, 1.0 };
+		std::vector<double> zs = { 0.0, 0.0, 0.0 };
+		Composites composites(xs, ys, zs, std::vector<double>{ 0.3, 0.6, 1.2 });
+
+		KrigingParameters parameters;
+		parameters.Type = KrigingParameters::KrigingType::Simple;
+		parameters.MinNumComposites = 1;
+		parameters.MaxNumComposites = 5;
+		parameters.MaxRadius = 100;
+		parameters.VariogramParameters = mParameters;
+
+		// Test a block beyond the variogram range gets the mean of the composites, as all weights are zero
+		auto estimates = KrigingEngine::KrigeOneBlock(20.0, 20.0, 0.0, parameters, composites);
+		ASSERT_TRUE(estimates.has_value());
+		EXPECT_NEAR(0.7, estimates.value()[0], mMaxError);
+	}
+
+	TEST_F(KrigingTests, UniversalKrigingReproducesDriftTest)
+	{
+		// Scattered composites whose values follow a quadratic trend exactly
+		std::vector<double> xs, ys, zs, linear, quadratic;
+		std::mt19937 generator(7);
+		std::uniform_real_distribution<double> distribution(0.0, 10.0);
+		for (int i = 0; i < 30; i++)
+		{
+			double x = distribution(generator), y = distribution(generator), z = 0.5 * distribution(generator);
+			xs.push_back(x);
+			ys.push_back(y);
+			zs.push_back(z);
+			linear.push_back(1.0 + 0.3 * x - 0.2 * y + 0.5 * z);
+			quadratic.push_back(1.0 + 0.3 * x - 0.2 * y + 0.05 * x * x + 0.04 * y * z);
+		}
+		Composites composites(xs, ys, zs, std::vector<std::vector<double>>{ linear, quadratic }, { "Linear", "Quadratic" });
+
+		KrigingParameters parameters;
+		parameters.Type = KrigingParameters::KrigingType::Universal;
+		parameters.Variables = { "Linear", "Quadratic" };
+		parameters.MinNumComposites = 1;
+		parameters.MaxNumComposites = 30;
+		parameters.MaxRadius = 100;
+		parameters.VariogramParameters = mParameters;
+		parameters.BlockParameters.BlockCoordExtents = { 0.0, 0.0, 0.0, 10.0, 10.0, 5.0 };
+		parameters.BlockParameters.BlockCountI = 5;
+		parameters.BlockParameters.BlockCountJ = 5;
+		parameters.BlockParameters.BlockCountK = 5;
+
+		// Test a linear drift reproduces the linear trend at a point, with either solver
+		double x0 = 4.0, y0 = 6.5, z0 = 2.0;
+		for (auto solver : { KrigingParameters::SolverType::Cholesky, KrigingParameters::SolverType::QR })
+		{
+			parameters.Solver = solver;
+			auto estimates = KrigingEngine::KrigeOneBlock(x0, y0, z0, parameters, composites);
+			ASSERT_TRUE(estimates.has_value());
+			EXPECT_NEAR(1.0 + 0.3 * x0 - 0.2 * y0 + 0.5 * z0, estimates.value()[0], 1e-8);
+		}
+
+		// Test a quadratic drift reproduces the block average of the quadratic trend over 2 x 2 x 2 points
+		parameters.Solver = KrigingParameters::SolverType::Cholesky;
+		parameters.Drift = KrigingParameters::DriftType::Quadratic;
+		parameters.BlockDiscretization = { 2, 2, 2 };
+		auto estimates = KrigingEngine::KrigeOneBlock(x0, y0, z0, parameters, composites);
+		ASSERT_TRUE(estimates.has_value());
+		double blockAverage = 0.0;
+		for (double dx : { -0.5, 0.5 })
+		{
+			for (double dy : { -0.5, 0.5 })
+			{
+				for (double dz : { -0.25, 0.25 })
+				{
+					double x = x0 + dx, y = y0 + dy, z = z0 + dz;
+					blockAverage += (1.0 + 0.3 * x - 0.2 * y + 0.05 * x * x + 0.04 * y * z) / 8;
+				}
+			}
+		}
+		EXPECT_NEAR(blockAverage, estimates.value()[1], 1e-8);
+
+		// Test blocks with fewer composites than drift terms are not estimated
+		parameters.MaxNumComposites = 9;
+		EXPECT_FALSE(KrigingEngine::KrigeOneBlock(x0, y0, z0, parameters, composites).has_value());
+	}
+
+	TEST_F(KrigingTests, UniversalKrigingRunMatchesOneBlockTest)
+	{
+		std::vector<double> xs, ys, zs, grades;
+		std::mt19937 generator(11);
+		std::uniform_real_distribution<double> distribution(0.0, 10.0);
+		for (int i = 0; i < 60; i++)
+		{
+			xs.push_back(distribution(generator));
+			ys.push_back(distribution(generator));
+			zs.push_back(distribution(generator));
+			grades.push_back(0.1 * xs.back() + 0.05 * distribution(generator));
+		}
+		Composites composites(xs, ys, zs, grades);
+
+		CoordinateExtents modelExtents = { 0.0, 0.0, 0.0, 10.0, 10.0, 10.0 };
+		BlockModelInfo modelInfo;
+		modelInfo.BlockCountI = 4;
+		modelInfo.BlockCountJ = 4;
+		modelInfo.BlockCountK = 4;
+		modelInfo.BlockCoordExtents = modelExtents;
+
+		KrigingParameters parameters;
+		parameters.Type = KrigingParameters::KrigingType::Universal;
+		parameters.MinNumComposites = 1;
+		parameters.MaxNumComposites = 12;
+		parameters.MaxRadius = 100;
+		parameters.NumThreads = 2;
+		parameters.VariogramParameters = mParameters;
+		parameters.BlockParameters = modelInfo;
+
+		// Test the run's precomputed drift terms give the same estimates as drift terms evaluated per block
+		Blocks blocks(modelInfo);
+		KrigingEngine::RunKriging(blocks, parameters, composites);
+		for (size_t j = 0; j < blocks.GetSize(); ++j)
+		{
+			auto estimates = KrigingEngine::KrigeOneBlock(blocks.GetX(j), blocks.GetY(j), blocks.GetZ(j), parameters, composites);
+			ASSERT_TRUE(estimates.has_value());
+			EXPECT_NEAR(estimates.value()[0], blocks.Grades[0].GetValue(j), 1e-8);
+		}
+	}
+
+	TEST_F(KrigingTests, IndicatorKrigingMatchesOrdinaryKrigingOfIndicatorsTest)
+	{
+		std::vector<double> xs, ys, zs, grades;
+		std::mt19937 generator(5);
+		std::uniform_real_distribution<double> distribution(0.0, 10.0);
+		for (int i = 0; i < 40; i++)
+		{
+			xs.push_back(distribution(generator));
+			ys.push_back(distribution(generator));
+			zs.push_back(distribution(generator));
+			grades.push_back(0.2 * distribution(generator));
+		}
+		std::vector<double> cutoffs = { 0.25, 0.5, 1.0, 1.5 };
+
+		// Reference: indicator columns kriged as separate variables
+		std::vector<std::vector<double>> indicators(cutoffs.size());
+		std::vector<std::string> indicatorNames;
+		for (size_t k = 0; k < cutoffs.size(); ++k)
+		{
+			for (double grade : grades)
+			{
+				indicators[k].push_back(grade <= cutoffs[k] ? 1.0 : 0.0);
+			}
+			indicatorNames.push_back("I" + std::to_string(k));
+		}
+		Composites indicatorComposites(xs, ys, zs, indicators, indicatorNames);
+		Composites composites(xs, ys, zs, grades);
+
+		KrigingParameters parameters;
+		parameters.MinNumComposites = 1;
+		parameters.MaxNumComposites = 12;
+		parameters.MaxRadius = 100;
+		parameters.VariogramParameters = mParameters;
+		KrigingParameters indicatorParameters = parameters;
+		indicatorParameters.Type = KrigingParameters::KrigingType::Indicator;
+		indicatorParameters.Cutoffs = cutoffs;
+		parameters.Variables = indicatorNames;
+
+		for (double x0 : { 1.0, 4.5, 8.0 })
+		{
+			auto reference = KrigingEngine::KrigeOneBlock(x0, 5.0, 3.0, parameters, indicatorComposites);
+			auto ccdf = KrigingEngine::KrigeOneBlock(x0, 5.0, 3.0, indicatorParameters, composites);
+			ASSERT_TRUE(reference.has_value());
+			ASSERT_TRUE(ccdf.has_value());
+			ASSERT_EQ(cutoffs.size(), ccdf.value().size());
+
+			// Test the shared solve matches separate solves after the GSLIB order relation correction
+			std::vector<double> clipped(cutoffs.size()), expected(cutoffs.size());
+			for (size_t k = 0; k < cutoffs.size(); ++k)
+			{
+				clipped[k] = std::min(std::max(reference.value()[k], 0.0), 1.0);
+			}
+			for (size_t k = 0; k < cutoffs.size(); ++k)
+			{
+				double upward = *std::max_element(clipped.begin(), clipped.begin() + k + 1);
+				double downward = *std::min_element(clipped.begin() + k, clipped.end());
+				expected[k] = 0.5 * (upward + downward);
+				EXPECT_NEAR(expected[k], ccdf.value()[k], 1e-12);
+			}
+
+			// Test the CCDF is a valid distribution
+			for (size_t k = 0; k < cutoffs.size(); ++k)
+			{
+				EXPECT_GE(ccdf.value()[k], 0.0);
+				EXPECT_LE(ccdf.value()[k], 1.0);
+				if (k > 0)
+				{
+					EXPECT_GE(ccdf.value()[k], ccdf.value()[k - 1]);
+				}
+			}
+		}
+	}
+
+	TEST_F(KrigingTests, IndicatorKrigingRunWritesOneColumnPerCutoffTest)
+	{
+		std::vector<double> xs = { 1.0, 9.0, 5.0, 2.0, 8.0 };
+		std::vector<double> ys = { 1.0, 2.0, 6.0, 9.0, 8.0 };
+		std::vector<double> zs = { 1.0, 5.0, 2.0, 8.0, 4.0 };
+		std::vector<double> grades = { 0.1, 0.4, 0.9, 1.6, 3.0 };
+		Composites composites(xs, ys, zs, grades);
+
+		BlockModelInfo modelInfo;
+		modelInfo.BlockCountI = 3;
+		modelInfo.BlockCountJ = 3;
+		modelInfo.BlockCountK = 3;
+		modelInfo.BlockCoordExtents = { 0.0, 0.0, 0.0, 10.0, 10.0, 10.0 };
+
+		KrigingParameters parameters;
+		parameters.Type = KrigingParameters::KrigingType::Indicator;
+		parameters.Cutoffs = { 0.5, 1.0, 2.0 };
+		parameters.MinNumComposites = 1;
+		parameters.MaxNumComposites = 5;
+		parameters.MaxRadius = 100;
+		parameters.NumThreads = 2;
+		parameters.VariogramParameters = mParameters;
+		parameters.BlockParameters = modelInfo;
+
+		// Test blocks need one column per cutoff
+		Blocks gradeBlocks(modelInfo);
+		EXPECT_THROW(KrigingEngine::RunKriging(gradeBlocks, parameters, composites), std::invalid_argument);
+
+		// Test every block's CCDF matches the single block estimate
+		Blocks blocks(modelInfo, parameters.GetEstimateNames());
+		KrigingEngine::RunKriging(blocks, parameters, composites);
+		for (size_t j = 0; j < blocks.GetSize(); ++j)
+		{
+			auto ccdf = KrigingEngine::KrigeOneBlock(blocks.GetX(j), blocks.GetY(j), blocks.GetZ(j), parameters, composites);
+			ASSERT_TRUE(ccdf.has_value());
+			for (size_t k = 0; k < parameters.Cutoffs.size(); ++k)
+			{
+				EXPECT_DOUBLE_EQ(ccdf.value()[k], blocks.Grades[k].GetValue(j));
+			}
+		}
+	}
+
+	TEST_F(KrigingTests, FixedSizeKernelsMatchDynamicKernelTest)
+	{
+		CoordinateExtents modelExtents;
+		modelExtents.MinX = 0;
+		modelExtents.MinY = 0;
+		modelExtents.MinZ = 0;
+		modelExtents.MaxX = 10;
+		modelExtents.MaxY = 10;
+		modelExtents.MaxZ = 10;
+
+		BlockModelInfo modelInfo;
+		modelInfo.BlockCountI = 5;
+		modelInfo.BlockCountJ = 5;
+		modelInfo.BlockCountK = 5;
+		modelInfo.BlockCoordExtents = modelExtents;
+
+		KrigingParameters parameters;
+		parameters.Type = KrigingParameters::KrigingType::Ordinary;
+		parameters.MinNumComposites = 1;
+		parameters.MaxRadius = 20;
+		parameters.VariogramParameters = mParameters;
+		parameters.BlockParameters = modelInfo;
+
+		// Generate composites on a deterministic pseudo-random pattern
+		std::default_random_engine gen(42);
+		std::uniform_real_distribution<double> dist(0, 1);
+		std::vector<double> x, y, z, grade;
+		for (int i = 0; i < 200; i++)
+		{
+			x.emplace_back(dist(gen) * 10);
+			y.emplace_back(dist(gen) * 10);
+			z.emplace_back(dist(gen) * 10);
+			grade.emplace_back(dist(gen));
+		}
+		Composites composites(x, y, z, grade);
+
+		// Cover each fixed-size kernel, and the dynamic kernel
+		for (int maxNumComposites : { 5, 16, 20, 32, 40, 60 })
+		{
+			parameters.MaxNumComposites = maxNumComposites;
+
+			Blocks blocks(modelInfo);
+			KrigingEngine::RunKriging(blocks, parameters, composites);
+
+			for (size_t i = 0; i < blocks.GetSize(); i++)
+			{
+				auto expected = KrigingEngine::KrigeOneBlock(blocks.GetX(i), blocks.GetY(i), blocks.GetZ(i), parameters, composites);
+				ASSERT_TRUE(blocks.Grades[0][i].has_value());
+				ASSERT_NEAR(expected.value()[0], blocks.Grades[0][i].value(), mMaxError);
+			}
+		}
+	}
+
+	TEST_F(KrigingTests, MultiVariableKrigingSharesWeightsTest)
+	{
+		// Define the coordinates and values of the composites, with variables derived from the first
+		std::vector<double> xs = { 0.0, 1.0, 2.0, 3.0, 4.0, 0.5 };
+		std::vector<double> ys = { 0.0, 1.5, 2.0, 3.5, 4.0, 2.5 };
+		std::vector<double> zs = { 0.0, 1.0, 2.5, 3.0, 4.0, 1.0 };
+		std::vector<double> au = { 0.10, 0.12, 0.82, 0.75, 0.21, 0.33 };
+		std::vector<double> cu, s;
+		for (double value : au)
+		{
+			cu.push_back(2.0 * value);
+			s.push_back(value + 1.0);
+		}
+		Composites composites(xs, ys, zs, { au, cu, s }, { "Au", "Cu", "S" });
+
+		KrigingParameters parameters;
+		parameters.MinNumComposites = 1;
+		parameters.MaxNumComposites = 6;
+		parameters.MaxRadius = 100;
+		parameters.VariogramParameters = mParameters;
+
+		auto estimates = KrigingEngine::KrigeOneBlock(2.5, 2.0, 1.5, parameters, composites);
+		ASSERT_TRUE(estimates.has_value());
+		ASSERT_EQ(3, estimates.value().size());
+
+		// Test first variable matches single variable kriging
+		double expected = KrigingEngine::OrdinaryKrigingPoint(2.5, 2.0, 1.5, xs, ys, zs, au, mParameters);
+		EXPECT_NEAR(expected, estimates.value()[0], mMaxError);
+
+		// Weights sum to one, so linear transforms of a variable carry through to the estimates
+		EXPECT_NEAR(2.0 * expected, estimates.value()[1], mMaxError);
+		EXPECT_NEAR(expected + 1.0, estimates.value()[2], mMaxError);
+	}
+
+	TEST_F(KrigingTests, OneSampleDiagnosticsMatchClosedFormTest)
+	{
+		// With one sample the weight is 1 and mu = k10 - C(0)
+		std::vector<double> xs = { 2.0 };
+		std::vector<double> ys = { 0.0 };
+		std::vector<double> zs = { 1.0 };
+		Composites composites(xs, ys, zs, std::vector<double>{ 0.12 });
+
+		KrigingParameters parameters;
+		parameters.MinNumComposites = 1;
+		parameters.MaxNumComposites = 5;
+		parameters.MaxRadius = 100;
+		parameters.VariogramParameters = mParameters;
+
+		KrigingDiagnostics diagnostics;
+		auto estimates = KrigingEngine::KrigeOneBlock(2.5, 2.5, 2.5, parameters, composites, &diagnostics);
+		ASSERT_TRUE(estimates.has_value());
+
+		double distance = sqrt(0.5 * 0.5 + 2.5 * 2.5 + 1.5 * 1.5);
+		double c00 = KrigingEngine::Covariance(0.0, mParameters);
+		double c10 = KrigingEngine::Covariance(distance, mParameters);
+
+		EXPECT_EQ(1, diagnostics.NumSamples);
+		EXPECT_NEAR(distance, diagnostics.AverageDistance, mMaxError);
+		EXPECT_NEAR(2.0 * (c00 - c10), diagnostics.KrigingVariance, mMaxError);
+		EXPECT_NEAR(c10 / c00, diagnostics.SlopeOfRegression, mMaxError);
+		EXPECT_NEAR(0.0, diagnostics.SumNegativeWeights, mMaxError);
+	}
+
+	TEST_F(KrigingTests, TiledSearchMatchesPerBlockSearchTest)
+	{
+		CoordinateExtents modelExtents;
+		modelExtents.MinX = 0;
+		modelExtents.MinY = 0;
+		modelExtents.MinZ = 0;
+		modelExtents.MaxX = 10;
+		modelExtents.MaxY = 10;
+		modelExtents.MaxZ = 10;
+
+		// Block counts not divisible by the tile size, so edge tiles are partial
+		BlockModelInfo modelInfo;
+		modelInfo.BlockCountI = 7;
+		modelInfo.BlockCountJ = 5;
+		modelInfo.BlockCountK = 6;
+		modelInfo.BlockCoordExtents = modelExtents;
+
+		KrigingParameters parameters;
+		parameters.MinNumComposites = 3;
+		parameters.MaxNumComposites = 4;
+		parameters.MaxRadius = 5;
+		parameters.OutputDiagnostics = true;
+		parameters.VariogramParameters = mParameters;
+		parameters.BlockParameters = modelInfo;
+		parameters.TileSize = 3;
+
+		std::vector<double> xs = { 1.0, 4.0, 8.0, 2.0, 9.0, 5.0, 7.0, 3.5, 6.5 };
+		std::vector<double> ys = { 2.0, 6.0, 1.0, 8.0, 9.0, 5.0, 3.0, 7.5, 2.5 };
+		std::vector<double> zs = { 3.0, 2.0, 7.0, 5.0, 1.0, 9.0, 6.0, 8.5, 4.5 };
+		std::vector<double> grades = { 0.1, 0.4, 0.3, 0.8, 0.2, 0.5, 0.6, 0.7, 0.9 };
+		Composites composites(xs, ys, zs, grades);
+
+		Blocks perBlock(modelInfo);
+		parameters.SearchMode = KrigingParameters::SearchType::PerBlock;
+		KrigingEngine::RunKriging(perBlock, parameters, composites);
+
+		Blocks tiled(modelInfo);
+		parameters.SearchMode = KrigingParameters::SearchType::Tiled;
+		KrigingEngine::RunKriging(tiled, parameters, composites);
+
+		// Test every block, including unestimated blocks, matches the per-block search
+		for (size_t i = 0; i < perBlock.GetSize(); i++)
+		{
+			ASSERT_EQ(perBlock.Grades[0].HasValue(i), tiled.Grades[0].HasValue(i));
+			EXPECT_EQ(perBlock.Diagnostics[i].NumSamples, tiled.Diagnostics[i].NumSamples);
+			if (perBlock.Grades[0].HasValue(i))
+			{
+				EXPECT_NEAR(perBlock.Grades[0].GetValue(i), tiled.Grades[0].GetValue(i), mMaxError);
+			}
+		}
+	}
+
+	TEST_F(KrigingTests, TiledEllipsoidSearchMatchesPerBlockSearchTest)
+	{
+		CoordinateExtents modelExtents;
+		modelExtents.MinX = 0;
+		modelExtents.MinY = 0;
+		modelExtents.MinZ = 0;
+		modelExtents.MaxX = 10;
+		modelExtents.MaxY = 10;
+		modelExtents.MaxZ = 10;
+
+		// Block counts not divisible by the tile size, so edge tiles are partial
+		BlockModelInfo modelInfo;
+		modelInfo.BlockCountI = 7;
+		modelInfo.BlockCountJ = 5;
+		modelInfo.BlockCountK = 6;
+		modelInfo.BlockCoordExtents = modelExtents;
+
+		KrigingParameters parameters;
+		parameters.MinNumComposites = 3;
+		parameters.MaxNumComposites = 4;
+		parameters.MaxRadius = 8;
+		parameters.OutputDiagnostics = true;
+		parameters.VariogramParameters = mParameters;
+		parameters.BlockParameters = modelInfo;
+		parameters.TileSize = 3;
+
+		// Flat search ellipsoid rotated so its axes are not aligned with the block grid
+		parameters.SearchEllipsoid.RangeSemiMajor = 5;
+		parameters.SearchEllipsoid.RangeMinor = 3;
+		parameters.SearchEllipsoid.Azimuth = 30;
+		parameters.SearchEllipsoid.Dip = 15;
+
+		std::vector<double> xs = { 1.0, 4.0, 8.0, 2.0, 9.0, 5.0, 7.0, 3.5, 6.5 };
+		std::vector<double> ys = { 2.0, 6.0, 1.0, 8.0, 9.0, 5.0, 3.0, 7.5, 2.5 };
+		std::vector<double> zs = { 3.0, 2.0, 7.0, 5.0, 1.0, 9.0, 6.0, 8.5, 4.5 };
+		std::vector<double> grades = { 0.1, 0.4, 0.3, 0.8, 0.2, 0.5, 0.6, 0.7, 0.9 };
+		Composites composites(xs, ys, zs, { grades }, { "Grade" }, parameters.GetSearchAnisotropy());
+
+		Blocks perBlock(modelInfo);
+		parameters.SearchMode = KrigingParameters::SearchType::PerBlock;
+		KrigingEngine::RunKriging(perBlock, parameters, composites);
+
+		Blocks tiled(modelInfo);
+		parameters.SearchMode = KrigingParameters::SearchType::Tiled;
+		KrigingEngine::RunKriging(tiled, parameters, composites);
+
+		// Test every block, including unestimated blocks, matches the per-block search
+		for (size_t i = 0; i < perBlock.GetSize(); i++)
+		{
+			ASSERT_EQ(perBlock.Grades[0].HasValue(i), tiled.Grades[0].HasValue(i));
+			EXPECT_EQ(perBlock.Diagnostics[i].NumSamples, tiled.Diagnostics[i].NumSamples);
+			if (perBlock.Grades[0].HasValue(i))
+			{
+				EXPECT_NEAR(perBlock.Grades[0].GetValue(i), tiled.Grades[0].GetValue(i), mMaxError);
+			}
+		}
+	}
+
+	TEST_F(KrigingTests, AnisotropicKrigingMatchesScaledCoordinatesTest)
+	{
+		// Semi-major range along east is half the major range, so anisotropic kriging equals isotropic kriging
+		// with east coordinates doubled
+		VariogramParameters anisotropic = mParameters;
+		anisotropic.RangeSemiMajor = mParameters.Range / 2.0;
+		anisotropic.RangeMinor = mParameters.Range;
+
+		std::vector<double> xs = { 1.0, 4.0, 8.0, 2.0, 9.0, 5.0, 7.0 };
+		std::vector<double> ys = { 2.0, 6.0, 1.0, 8.0, 9.0, 5.0, 3.0 };
+		std::vector<double> zs = { 3.0, 2.0, 7.0, 5.0, 1.0, 9.0, 6.0 };
+		std::vector<double> grades = { 0.1, 0.4, 0.3, 0.8, 0.2, 0.5, 0.6 };
+		std::vector<double> scaledXs;
+		for (double x : xs)
+		{
+			scaledXs.push_back(2.0 * x);
+		}
+
+		double expected = KrigingEngine::OrdinaryKrigingPoint(2.0 * 4.5, 5.5, 4.5, scaledXs, ys, zs, grades, mParameters);
+		double result = KrigingEngine::OrdinaryKrigingPoint(4.5, 5.5, 4.5, xs, ys, zs, grades, anisotropic);
+		EXPECT_NEAR(expected, result, mMaxError);
+
+		// Test block kriging with precomputed coordinates matches single block kriging
+		CoordinateExtents modelExtents;
+		modelExtents.MinX = 0;
+		modelExtents.MinY = 0;
+		modelExtents.MinZ = 0;
+		modelExtents.MaxX = 10;
+		modelExtents.MaxY = 10;
+		modelExtents.MaxZ = 10;
+
+		BlockModelInfo modelInfo;
+		modelInfo.BlockCountI = 3;
+		modelInfo.BlockCountJ = 3;
+		modelInfo.BlockCountK = 3;
+		modelInfo.BlockCoordExtents = modelExtents;
+
+		KrigingParameters parameters;
+		parameters.MinNumComposites = 3;
+		parameters.MaxNumComposites = 7;
+		parameters.MaxRadius = 20;
+		parameters.VariogramParameters = anisotropic;
+		parameters.BlockParameters = modelInfo;
+
+		Composites composites(xs, ys, zs, grades);
+		Blocks blocks(modelInfo);
+		KrigingEngine::RunKriging(blocks, parameters, composites);
+
+		for (size_t i = 0; i < blocks.GetSize(); i++)
+		{
+			auto single = KrigingEngine::KrigeOneBlock(blocks.GetX(i), blocks.GetY(i), blocks.GetZ(i), parameters, composites);
+			ASSERT_TRUE(single.has_value());
+			EXPECT_NEAR(single.value()[0], blocks.Grades[0].GetValue(i), mMaxError);
+		}
+	}
+
+	TEST_F(KrigingTests, RunKrigingOutputsDiagnosticsTest)
+	{
+		CoordinateExtents modelExtents;
+		modelExtents.MinX = 0;
+		modelExtents.MinY = 0;
+		modelExtents.MinZ = 0;
+		modelExtents.MaxX = 10;
+		modelExtents.MaxY = 10;
+		modelExtents.MaxZ = 10;
+
+		BlockModelInfo modelInfo;
+		modelInfo.BlockCountI = 4;
+		modelInfo.BlockCountJ = 4;
+		modelInfo.BlockCountK = 4;
+		modelInfo.BlockCoordExtents = modelExtents;
+
+		KrigingParameters parameters;
+		parameters.MinNumComposites = 3;
+		parameters.MaxNumComposites = 8;
+		parameters.MaxRadius = 20;
+		parameters.OutputDiagnostics = true;
+		parameters.VariogramParameters = mParameters;
+		parameters.BlockParameters = modelInfo;
+
+		std::vector<double> xs = { 1.0, 4.0, 8.0, 2.0, 9.0, 5.0, 7.0 };
+		std::vector<double> ys = { 2.0, 6.0, 1.0, 8.0, 9.0, 5.0, 3.0 };
+		std::vector<double> zs = { 3.0, 2.0, 7.0, 5.0, 1.0, 9.0, 6.0 };
+		std::vector<double> grades = { 0.1, 0.4, 0.3, 0.8, 0.2, 0.5, 0.6 };
+		Composites composites(xs, ys, zs, grades);
+
+		Blocks blocks(modelInfo);
+		KrigingEngine::RunKriging(blocks, parameters, composites);
+
+		// Test every estimated block has consistent diagnostics
+		ASSERT_EQ(blocks.GetSize(), blocks.Diagnostics.size());
+		for (size_t i = 0; i < blocks.GetSize(); i++)
+		{
+			const auto& diagnostics = blocks.Diagnostics[i];
+			ASSERT_TRUE(blocks.Grades[0][i].has_value());
+			EXPECT_EQ(7, diagnostics.NumSamples);
+			EXPECT_GE(diagnostics.KrigingVariance, -mMaxError);
+			EXPECT_LE(diagnostics.SumNegativeWeights, 0.0);
+			EXPECT_GT(diagnostics.AverageDistance, 0.0);
+		}
+	}
+
 	TEST_F(KrigingTests, FullBlockModelKrigingTest)
 	{
 		// Input parameters
@@ -276,7 +934,7 @@ namespace KrigingEngineTests
 		// Print out the first 5 block I, J, K, and grade values
 		for (int i = 0; i < 5; i++)
 		{
-			std::cout << "Block: " << i << ", Grade: " << blocks.Grade[i].value() << std::endl;
+			std::cout << "Block: " << i << ", Grade: " << blocks.Grades[0][i].value() << std::endl;
 		}
 	}
 
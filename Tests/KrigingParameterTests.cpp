@@ -43,12 +43,59 @@ namespace KrigingParameterTests
 		EXPECT_EQ(parameters.Type, KrigingParameters::KrigingType::Ordinary);
 		EXPECT_EQ(parameters.MinNumComposites, 1);
 		EXPECT_EQ(parameters.MaxNumComposites, 15);
+		EXPECT_EQ(parameters.Solver, KrigingParameters::SolverType::Cholesky);
+		EXPECT_EQ(parameters.Variables, std::vector<std::string>({ "Grade" }));
+		EXPECT_TRUE(parameters.GlobalMeans.empty());
+		EXPECT_EQ(parameters.Drift, KrigingParameters::DriftType::Linear);
+		EXPECT_TRUE(parameters.Cutoffs.empty());
+		EXPECT_FALSE(parameters.CrossValidation);
+		EXPECT_EQ(parameters.SearchMode, KrigingParameters::SearchType::PerBlock);
+		EXPECT_EQ(parameters.KdTreeLeafSize, 10);
+		EXPECT_TRUE(parameters.GetSearchAnisotropy().IsIsotropic());
+		EXPECT_DOUBLE_EQ(parameters.GetMaxSearchRange(), 200);
+		EXPECT_EQ(parameters.CovarianceTable, KrigingParameters::CovarianceTableType::None);
+		EXPECT_EQ(parameters.CovarianceTableResolution, 512);
+		EXPECT_EQ(parameters.BlockDiscretization.CountI * parameters.BlockDiscretization.CountJ * parameters.BlockDiscretization.CountK, 1);
 
 		// Spot check imported parameters
 		EXPECT_DOUBLE_EQ(parameters.MaxRadius, 200);
 		EXPECT_DOUBLE_EQ(parameters.BlockParameters.BlockCoordExtents.MaxZ, 700);
 	}
 
+	TEST(SerializeNestedStructures, DerivesSillAndFirstStructure)
+	{
+		// Get JSON file path
+		std::string filePath = TestHelpers::GetTestDataFilePath("ExKrigingParamsNestedStructures.json");
+
+		KrigingParameters parameters;
+		EXPECT_NO_THROW(parameters.SerializeParameters(filePath));
+
+		// Test structures were read, with the sill and single structure fields derived from them
+		const auto& variogram = parameters.VariogramParameters;
+		ASSERT_EQ(variogram.NestedStructures.size(), 2);
+		EXPECT_EQ(variogram.NestedStructures[1].Structure, VariogramParameters::StructureType::Exponential);
+		EXPECT_DOUBLE_EQ(variogram.NestedStructures[1].Contribution, 0.4);
+		EXPECT_DOUBLE_EQ(variogram.NestedStructures[1].RangeMinor, 250);
+		EXPECT_DOUBLE_EQ(variogram.Sill, 1.0);
+		EXPECT_DOUBLE_EQ(variogram.Range, 60);
+		EXPECT_DOUBLE_EQ(variogram.RangeSemiMajor, 30);
+		EXPECT_DOUBLE_EQ(variogram.Azimuth, 45);
+	}
+
+	TEST(SerializeIndicatorParameters, NamesOneEstimatePerCutoff)
+	{
+		// Get JSON file path
+		std::string filePath = TestHelpers::GetTestDataFilePath("ExKrigingParamsIndicator.json");
+
+		KrigingParameters parameters;
+		EXPECT_NO_THROW(parameters.SerializeParameters(filePath));
+
+		// Test cutoffs were read, with one CCDF column per cutoff
+		EXPECT_EQ(parameters.Type, KrigingParameters::KrigingType::Indicator);
+		EXPECT_EQ(parameters.Cutoffs, std::vector<double>({ 0.2, 0.5, 1.0 }));
+		EXPECT_EQ(parameters.GetEstimateNames(), std::vector<std::string>({ "Grade<=0.2", "Grade<=0.5", "Grade<=1" }));
+	}
+
 	TEST(TrySerializeBadParameters, InvalidVariogramStructureThrowsError)
 	{
 		// Get JSON file path
@@ -70,4 +117,26 @@ namespace KrigingParameterTests
 		KrigingParameters parameters;
 		EXPECT_THROW(parameters.SerializeParameters(filePath), std::invalid_argument);
 	}
+
+	TEST(TrySerializeBadParameters, TooFewCompositesForDriftThrowsError)
+	{
+		// Get JSON file path; quadratic drift has 10 terms, but at most 8 composites are used
+		std::string filePath = TestHelpers::GetTestDataFilePath("ExKrigingParamsTooFewCompositesForDrift.json");
+
+		// Serialize kriging parameters from file
+		// Test exception is thrown
+		KrigingParameters parameters;
+		EXPECT_THROW(parameters.SerializeParameters(filePath), std::invalid_argument);
+	}
+
+	TEST(TrySerializeBadParameters, RepeatedCutoffsThrowsError)
+	{
+		// Get JSON file path; indicator cutoffs must be strictly increasing
+		std::string filePath = TestHelpers::GetTestDataFilePath("ExKrigingParamsRepeatedCutoffs.json");
+
+		// Serialize kriging parameters from file
+		// Test exception is thrown
+		KrigingParameters parameters;
+		EXPECT_THROW(parameters.SerializeParameters(filePath), std::invalid_argument);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../KrigingLib/ThreadPool.hpp"
+
+/**
+ * @brief Unit tests for work-stealing thread pool
+ */
+namespace ThreadPoolTests
+{
+	TEST(ParallelForTest, ProcessesEveryItemOnce)
+	{
+		ThreadPool pool(4);
+		size_t count = 10007;
+		std::vector<std::atomic<int>> visits(count);
+
+		// Run twice to confirm the pool is reusable
+		for (int run = 1; run <= 2; run++)
+		{
+			auto statistics = pool.ParallelFor(count, 16, [&visits](size_t begin, size_t end, size_t /*threadIndex*/) {
+				for (size_t i = begin; i < end; i++)
+				{
+					visits[i]++;
+				}
+				});
+
+			// Test every item was visited once per run
+			for (size_t i = 0; i < count; i++)
+			{
+				ASSERT_EQ(run, visits[i].load());
+			}
+
+			// Test statistics account for every item
+			size_t itemsProcessed = 0;
+			for (const auto& stats : statistics)
+			{
+				itemsProcessed += stats.ItemsProcessed;
+			}
+			EXPECT_EQ(4, statistics.size());
+			EXPECT_EQ(count, itemsProcessed);
+		}
+	}
+
+	TEST(ParallelForTest, IdleThreadsStealFromBusyThreads)
+	{
+		ThreadPool pool(2);
+		size_t count = 64;
+
+		// The first thread blocks on its first chunk until every other chunk has been processed, so the second
+		// thread must steal the remainder of the first thread's range
+		std::atomic<size_t> itemsDone = 0;
+		auto statistics = pool.ParallelFor(count, 1, [&](size_t begin, size_t end, size_t /*threadIndex*/) {
+			if (begin == 0)
+			{
+				while (itemsDone.load() < count - 1)
+				{
+					std::this_thread::yield();
+				}
+			}
+			itemsDone += end - begin;
+			});
+
+		EXPECT_EQ(count, itemsDone.load());
+		EXPECT_GT(statistics[1].ChunksStolen, 0);
+	}
+
+	TEST(ParallelForTest, RethrowsWorkerException)
+	{
+		ThreadPool pool(2);
+		EXPECT_THROW(pool.ParallelFor(100, 10, [](size_t begin, size_t /*end*/, size_t /*threadIndex*/) {
+			if (begin == 50)
+			{
+				throw std::runtime_error("Test exception");
+			}
+			}), std::runtime_error);
+	}
+}
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../KrigingLib/VariogramModel.hpp"
+#include "../KrigingLib/KrigingEngine.hpp"
+#include "../KrigingLib/DistanceKernel.hpp"
+
+/**
+ * @brief Unit tests for compiled variogram models with nested structures
+ */
+namespace VariogramModelTests
+{
+	const double mMaxError = 1e-12;
+
+	static VariogramParameters InitNestedParameters()
+	{
+		VariogramParameters parameters;
+		parameters.Nugget = 0.1;
+		parameters.Sill = 1.0;
+
+		VariogramParameters::NestedStructure shortRange;
+		shortRange.Structure = VariogramParameters::StructureType::Spherical;
+		shortRange.Contribution = 0.5;
+		shortRange.Range = 50.0;
+
+		VariogramParameters::NestedStructure longRange;
+		longRange.Structure = VariogramParameters::StructureType::Exponential;
+		longRange.Contribution = 0.4;
+		longRange.Range = 200.0;
+
+		parameters.NestedStructures = { shortRange, longRange };
+		return parameters;
+	}
+
+	TEST(VariogramModelTest, SingleStructureMatchesParameters)
+	{
+		VariogramParameters parameters;
+		parameters.Nugget = 0.2;
+		parameters.Sill = 1.0;
+		parameters.Range = 100.0;
+		parameters.Structure = VariogramParameters::StructureType::Gaussian;
+		VariogramModel model(parameters);
+
+		// Test the single structure uses the contribution Sill - Nugget
+		double ha = 0.4;
+		EXPECT_TRUE(model.IsDistanceOnly());
+		EXPECT_NEAR(0.2 + 0.8 * (1 - exp(-3 * ha * ha)), model.Variogram(40.0), mMaxError);
+		EXPECT_NEAR(1.0 - model.Variogram(40.0), model.Covariance(40.0), mMaxError);
+	}
+
+	TEST(VariogramModelTest, NestedStructuresSumContributions)
+	{
+		VariogramModel model(InitNestedParameters());
+
+		// Test each structure contributes its own shape at its own range
+		double h = 30.0;
+		double spherical = 1.5 * (h / 50.0) - 0.5 * pow(h / 50.0, 3);
+		double exponential = 1 - exp(-3 * h / 200.0);
+		EXPECT_NEAR(0.1 + 0.5 * spherical + 0.4 * exponential, model.Variogram(h), mMaxError);
+
+		// Beyond the short range only the long range structure still varies
+		EXPECT_NEAR(0.1 + 0.5 + 0.4 * (1 - exp(-3 * 80.0 / 200.0)), model.Variogram(80.0), mMaxError);
+		EXPECT_NEAR(model.Covariance(h), model.Covariance(h, 0.0, 0.0), mMaxError);
+	}
+
+	TEST(VariogramModelTest, NestedAnisotropiesAreRelativeToFirstStructure)
+	{
+		VariogramParameters parameters = InitNestedParameters();
+		parameters.NestedStructures[0].RangeSemiMajor = 25.0;
+		parameters.NestedStructures[0].Azimuth = 30.0;
+		parameters.NestedStructures[1].RangeMinor = 50.0;
+		parameters.NestedStructures[1].Dip = 20.0;
+		VariogramModel model(parameters);
+		EXPECT_FALSE(model.IsDistanceOnly());
+
+		// Reference: each structure's own anisotropic distance of a model space lag
+		const auto& structures = parameters.NestedStructures;
+		Anisotropy first(structures[0].Range, structures[0].RangeSemiMajor, structures[0].RangeMinor,
+			structures[0].Azimuth, structures[0].Dip, structures[0].Plunge);
+		Anisotropy second(structures[1].Range, structures[1].RangeSemiMajor, structures[1].RangeMinor,
+			structures[1].Azimuth, structures[1].Dip, structures[1].Plunge);
+		double dx = 12.0, dy = -7.0, dz = 5.0;
+		double x1, y1, z1, x2, y2, z2;
+		first.Transform(dx, dy, dz, x1, y1, z1);
+		second.Transform(dx, dy, dz, x2, y2, z2);
+		double ha1 = sqrt(x1 * x1 + y1 * y1 + z1 * z1) / structures[0].Range;
+		double ha2 = sqrt(x2 * x2 + y2 * y2 + z2 * z2) / structures[1].Range;
+		double expected = 1.0 - (0.1 + 0.5 * (1.5 * ha1 - 0.5 * ha1 * ha1 * ha1) + 0.4 * (1 - exp(-3 * ha2)));
+
+		// Test the model evaluates the lag in the first structure's isotropic space
+		EXPECT_NEAR(expected, model.Covariance(x1, y1, z1), mMaxError);
+	}
+
+	TEST(VariogramModelTest, SharedAnisotropyIsDistanceOnly)
+	{
+		VariogramParameters parameters = InitNestedParameters();
+		for (auto& structure : parameters.NestedStructures)
+		{
+			structure.RangeSemiMajor = structure.Range / 2;
+			structure.Azimuth = 60.0;
+			structure.Dip = 10.0;
+		}
+
+		// Test structures with the same angles and range ratios need no relative transform
+		VariogramModel model(parameters);
+		EXPECT_TRUE(model.IsDistanceOnly());
+	}
+
+	TEST(VariogramModelTest, NestedKrigingWeightsSumToOne)
+	{
+		VariogramParameters parameters = InitNestedParameters();
+		parameters.NestedStructures[1].RangeSemiMajor = 100.0;
+		parameters.NestedStructures[1].Azimuth = 90.0;
+
+		std::vector<double> xs = { 10.0, 40.0, 25.0, 5.0, 35.0 };
+		std::vector<double> ys = { 20.0, 15.0, 45.0, 5.0, 40.0 };
+		std::vector<double> zs = { 0.0, 5.0, 10.0, 0.0, 5.0 };
+
+		// Test a constant field is reproduced exactly, as the ordinary kriging weights sum to one
+		std::vector<double> values(xs.size(), 2.5);
+		double estimate = KrigingEngine::OrdinaryKrigingPoint(20.0, 25.0, 3.0, xs, ys, zs, values, parameters);
+		EXPECT_NEAR(2.5, estimate, 1e-9);
+	}
+
+	TEST(VariogramModelTest, BatchCovariancesMatchScalar)
+	{
+		VariogramParameters parameters = InitNestedParameters();
+		VariogramModel exact(parameters);
+		VariogramModel tabulated(parameters, KrigingParameters::CovarianceTableType::Cubic, 128);
+
+		// Test lags spanning several batches give exactly the per-lag covariances
+		for (const VariogramModel* model : { &exact, &tabulated })
+		{
+			std::vector<double> values(150);
+			for (size_t i = 0; i < values.size(); ++i)
+			{
+				values[i] = 2.75 * i;
+			}
+			model->Covariances(values.data(), values.size());
+			for (size_t i = 0; i < values.size(); ++i)
+			{
+				EXPECT_EQ(model->Covariance(2.75 * i), values[i]);
+			}
+		}
+	}
+
+	TEST(DistanceKernelTest, MatchesScalarDistances)
+	{
+		std::vector<double> xs, ys, zs;
+		for (int i = 0; i < 21; i++)
+		{
+			xs.push_back(1.5 * i - 7.0);
+			ys.push_back(0.25 * i * i);
+			zs.push_back(10.0 - 3.0 * i);
+		}
+
+		// Test every count, so vector widths and scalar remainders are all covered
+		for (size_t count = 0; count <= xs.size(); ++count)
+		{
+			std::vector<double> distances(count + 1, -1.0);
+			DistanceKernel::Compute(2.0, -1.0, 4.0, xs.data(), ys.data(), zs.data(), count, distances.data());
+			for (size_t i = 0; i < count; ++i)
+			{
+				double dx = xs[i] - 2.0, dy = ys[i] + 1.0, dz = zs[i] - 4.0;
+				EXPECT_NEAR(sqrt(dx * dx + dy * dy + dz * dz), distances[i], mMaxError);
+			}
+			EXPECT_EQ(-1.0, distances[count]);
+		}
+	}
+
+	TEST(DistanceKernelTest, InstructionSetsMatchScalar)
+	{
+		std::vector<double> xs, ys, zs;
+		for (int i = 0; i < 21; i++)
+		{
+			xs.push_back(0.37 * i - 3.1);
+			ys.push_back(1.0 / (i + 1));
+			zs.push_back(-0.11 * i * i);
+		}
+		std::vector<double> expected(xs.size());
+		DistanceKernel::Compute(DistanceKernel::InstructionSet::Scalar, 0.3, 0.7, -1.9, xs.data(), ys.data(), zs.data(),
+			xs.size(), expected.data());
+
+		// Test every supported kernel gives identical distances at every count, so results do not depend on the CPU
+		for (auto instructionSet : { DistanceKernel::InstructionSet::Avx, DistanceKernel::InstructionSet::Avx512 })
+		{
+			if (!DistanceKernel::IsSupported(instructionSet))
+			{
+				continue;
+			}
+			for (size_t count = 0; count <= xs.size(); ++count)
+			{
+				std::vector<double> distances(count + 1, -1.0);
+				DistanceKernel::Compute(instructionSet, 0.3, 0.7, -1.9, xs.data(), ys.data(), zs.data(), count, distances.data());
+				for (size_t i = 0; i < count; ++i)
+				{
+					EXPECT_EQ(expected[i], distances[i]);
+				}
+				EXPECT_EQ(-1.0, distances[count]);
+			}
+		}
+	}
+
+	TEST(CovarianceTableTest, ErrorNearSampledMaximum)
+	{
+		VariogramParameters parameters = InitNestedParameters();
+		parameters.NestedStructures[0].Structure = VariogramParameters::StructureType::Gaussian;
+		VariogramModel exact(parameters);
+
+		for (auto table : { KrigingParameters::CovarianceTableType::Linear, KrigingParameters::CovarianceTableType::Cubic })
+		{
+			VariogramModel tabulated(parameters, table, 256);
+			EXPECT_GT(tabulated.GetMaxSampledTableError(), 0.0);
+
+			// Test dense lags within and beyond the tables stay close to the maximum error at the sampled lags
+			double maxError = 0.0;
+			for (int i = 0; i <= 100000; i++)
+			{
+				double h = i * 0.025;
+				maxError = std::max(maxError, std::abs(tabulated.Covariance(h) - exact.Covariance(h)));
+			}
+			EXPECT_LE(maxError, 1.5 * tabulated.GetMaxSampledTableError());
+		}
+	}
+
+	TEST(CovarianceTableTest, CubicMoreAccurateThanLinear)
+	{
+		VariogramParameters parameters = InitNestedParameters();
+		VariogramModel linear(parameters, KrigingParameters::CovarianceTableType::Linear, 512);
+		VariogramModel cubic(parameters, KrigingParameters::CovarianceTableType::Cubic, 512);
+
+		// Test the reported errors are small, and smaller for cubic interpolation
+		EXPECT_LT(linear.GetMaxSampledTableError(), 1e-5);
+		EXPECT_LT(cubic.GetMaxSampledTableError(), linear.GetMaxSampledTableError());
+	}
+
+	TEST(CovarianceTableTest, SphericalStructuresAreNotTabulated)
+	{
+		VariogramParameters parameters;
+		parameters.Nugget = 0.2;
+		parameters.Sill = 1.0;
+		parameters.Range = 100.0;
+		parameters.Structure = VariogramParameters::StructureType::Spherical;
+		VariogramModel exact(parameters);
+		VariogramModel tabulated(parameters, KrigingParameters::CovarianceTableType::Cubic, 16);
+
+		// Test spherical covariances are evaluated exactly
+		EXPECT_EQ(0.0, tabulated.GetMaxSampledTableError());
+		EXPECT_EQ(exact.Covariance(37.5), tabulated.Covariance(37.5));
+	}
+}